@@ -1,7 +1,10 @@
 #include <string.h>
 
 #include <a2blocked.h>
+#include "assert.h"
 #include "uarray2b.h"
+#include "sched.h"
+#include "workers.h"
 
 // define a private version of each function in A2Methods_T that we implement
 
@@ -9,7 +12,8 @@ typedef A2Methods_UArray2 A2;	// private abbreviation
 
 static A2 new(int width, int height, int size)
 {
-	return UArray2b_new_64K_block(width, height, size);
+	return UArray2b_new(width, height, size,
+			    UArray2b_default_blocksize(size));
 }
 
 static A2 new_with_blocksize(int width, int height, int size, int blocksize)
@@ -17,6 +21,15 @@ static A2 new_with_blocksize(int width, int height, int size, int blocksize)
 	return UArray2b_new(width, height, size, blocksize);
 }
 
+static A2 new_with_allocator(int width, int height, int size, int blocksize,
+			     Alloc_T alloc)
+{
+	if (blocksize < 1) {
+		blocksize = UArray2b_default_blocksize(size);
+	}
+	return UArray2b_new_in(width, height, size, blocksize, alloc);
+}
+
 static void a2free(A2 * array2p)
 {
 	UArray2b_free((UArray2b_T *) array2p);
@@ -51,6 +64,50 @@ static void map_block_major(A2 array2, A2Methods_applyfun apply, void *cl)
 	UArray2b_map(array2, (applyfun *) apply, cl);
 }
 
+typedef void spanfun(int i, int j, int n, UArray2b_T array2b, void *first,
+		     void *cl);
+
+static void map_block_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+	UArray2b_map_block_spans(array2, (spanfun *) apply, cl);
+}
+
+// rows are cut at block boundaries, the longest contiguous runs they have
+static void map_row_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+	UArray2b_map_row_spans(array2, (spanfun *) apply, cl);
+}
+
+struct parallel_closure {
+	A2 array2;
+	A2Methods_applyfun *apply;
+	void *cl;
+	int ntasks;
+};
+
+static void block_rows_task(int task, int thread, void *vcl)
+{
+	struct parallel_closure *pcl = vcl;
+	int lo, hi;
+	(void)thread;
+	Workers_split(UArray2b_block_rows(pcl->array2), pcl->ntasks, task,
+		      &lo, &hi);
+	UArray2b_map_block_rows(pcl->array2, lo, hi, (applyfun *) pcl->apply,
+				pcl->cl);
+}
+
+// each task is a band of whole block rows, so no block is shared
+static void parallel_map_block_major(A2 array2, A2Methods_applyfun apply,
+				     void *cl, int nthreads)
+{
+	assert(nthreads >= 1);
+	int blockRows = UArray2b_block_rows(array2);
+	int ntasks = nthreads * SCHED_TASKS_PER_THREAD;
+	struct parallel_closure pcl = { array2, apply, cl,
+		ntasks < blockRows ? ntasks : blockRows };
+	Sched_run(Sched_shared(nthreads), pcl.ntasks, block_rows_task, &pcl);
+}
+
 struct small_closure {
 	A2Methods_smallapplyfun *apply;
 	void *cl;
@@ -89,6 +146,13 @@ static struct A2Methods_T uarray2_methods_blocked_struct = {
 	NULL,			// small_map_col_major
 	small_map_block_major,
 	small_map_block_major,	// small_map_default
+	NULL,			// parallel_map_row_major
+	NULL,			// parallel_map_col_major
+	parallel_map_block_major,
+	parallel_map_block_major,	// parallel_map_default
+	new_with_allocator,
+	map_row_spans,
+	map_block_spans,
 };
 
 // finally the payoff: here is the exported pointer to the struct
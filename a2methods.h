@@ -1,6 +1,8 @@
 #ifndef A2METHODS_INCLUDED
 #define A2METHODS_INCLUDED
 
+#include "alloc.h"
+
 #define A2 A2Methods_UArray2
 
 typedef void *A2;               /* unknown type that represents a
@@ -14,6 +16,13 @@ typedef void A2Methods_Object;  /* an unknown sequence of bytes in memory
 typedef void A2Methods_applyfun(int i, int j, A2 array2,
                                 A2Methods_Object *ptr, void *cl);
 typedef void A2Methods_mapfun(A2 array2, A2Methods_applyfun apply, void *cl);
+typedef void A2Methods_parallelmapfun(A2 array2, A2Methods_applyfun apply,
+                                      void *cl, int nthreads);
+
+typedef void A2Methods_spanfun(int i, int j, int n, A2 array2,
+                               A2Methods_Object *first, void *cl);
+typedef void A2Methods_spanmapfun(A2 array2, A2Methods_spanfun apply,
+                                  void *cl);
 
 typedef void A2Methods_smallapplyfun(A2Methods_Object *ptr, void *cl);
 typedef void A2Methods_smallmapfun(A2 a2, A2Methods_smallapplyfun f, void *cl);
@@ -98,6 +107,54 @@ typedef struct A2Methods_T {
         void (*small_map_default)    (A2 a2, A2Methods_smallapplyfun apply,
                                       void *cl);
 
+        /*
+         * parallel mapping functions: each visits every cell exactly once,
+         * like the mapping function of the same name, but splits the rows,
+         * columns or blocks among 'nthreads' worker threads (nthreads < 1
+         * is a checked run-time error). The overall order of visits is
+         * unspecified and 'apply' is called concurrently for different
+         * cells, so it may only write to state belonging to its own cell.
+         *
+         * each of these is NULL exactly when the matching map is NULL
+         */
+        A2Methods_parallelmapfun *parallel_map_row_major;
+        A2Methods_parallelmapfun *parallel_map_col_major;
+        A2Methods_parallelmapfun *parallel_map_block_major;
+        A2Methods_parallelmapfun *parallel_map_default;
+
+        /* like new_with_blocksize, but the array's memory, cells and
+         * bookkeeping alike, comes from 'alloc' (see alloc.h; NULL means
+         * the heap), and a blocksize < 1 picks the default.
+         * With an arena the cells are uninitialized and 'free' releases
+         * nothing: the memory goes back when the arena is reset.
+         */
+        A2(*new_with_allocator)(int width, int height, int size,
+                                int blocksize, Alloc_T alloc);
+
+        /*
+         * span mapping functions: like the mapping function of the same
+         * name, but 'apply' is called once per run of cells that lie back
+         * to back in memory, rather than once per cell, with
+         *    i, j, the column and row of the first cell of the run
+         *    n, the number of cells in the run, which are
+         *       (i, j), (i + 1, j), ..., (i + n - 1, j)
+         *    array2, the array passed to the mapping function
+         *    first, a pointer to cell (i, j); cell (i + k, j) is at
+         *       first + k * size
+         *    cl, the closure pointer passed to the mapping function
+         * so a whole run can be moved with memcpy or vector code.
+         *
+         *   - row_spans visits rows in order of increasing row index, and
+         *     the runs of a row in order of increasing column
+         *   - block_spans visits each block before the next, each block a
+         *     row at a time
+         *
+         * each of these is NULL exactly when the matching map is NULL,
+         * except that row_spans is also given for blocked arrays
+         */
+        A2Methods_spanmapfun *map_row_spans;
+        A2Methods_spanmapfun *map_block_spans;
+
 } *A2Methods_T;
 
 #undef A2
@@ -0,0 +1,218 @@
+#include <string.h>
+
+#include "a2morton.h"
+#include "assert.h"
+#include "uarray2m.h"
+#include "sched.h"
+#include "workers.h"
+
+// define a private version of each function in A2Methods_T that we implement
+
+typedef A2Methods_UArray2 A2;	// private abbreviation
+
+static A2 new(int width, int height, int size)
+{
+	return UArray2m_new(width, height, size);
+}
+
+static A2 new_with_blocksize(int width, int height, int size, int blocksize)
+{
+	(void)blocksize;
+	return UArray2m_new(width, height, size);
+}
+
+static A2 new_with_allocator(int width, int height, int size, int blocksize,
+			     Alloc_T alloc)
+{
+	(void)blocksize;
+	return UArray2m_new_in(width, height, size, alloc);
+}
+
+static void a2free(A2 * array2p)
+{
+	UArray2m_free((UArray2m_T *) array2p);
+}
+
+static int width(A2 array2)
+{
+	return UArray2m_width(array2);
+}
+static int height(A2 array2)
+{
+	return UArray2m_height(array2);
+}
+static int size(A2 array2)
+{
+	return UArray2m_size(array2);
+}
+static int blocksize(A2 array2)
+{
+	(void)array2;
+	return 1;
+}
+
+static A2Methods_Object *at(A2 array2, int i, int j)
+{
+	return UArray2m_at(array2, i, j);
+}
+
+typedef void applyfun(int i, int j, UArray2m_T array2m, void *elem, void *cl);
+
+static void map_row_major(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+	UArray2m_map_row_major(array2, (applyfun *) apply, cl);
+}
+
+static void map_col_major(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+	UArray2m_map_col_major(array2, (applyfun *) apply, cl);
+}
+
+static void map_morton(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+	UArray2m_map(array2, (applyfun *) apply, cl);
+}
+
+typedef void spanfun(int i, int j, int n, UArray2m_T array2m, void *first,
+		     void *cl);
+
+// runs are mostly pairs of cells; see UArray2m_map_row_spans
+static void map_row_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+	UArray2m_map_row_spans(array2, (spanfun *) apply, cl);
+}
+
+struct parallel_closure {
+	A2 array2;
+	A2Methods_applyfun *apply;
+	void *cl;
+	int ntasks;
+};
+
+static void row_range_task(int task, int thread, void *vcl)
+{
+	struct parallel_closure *pcl = vcl;
+	int lo, hi;
+	(void)thread;
+	Workers_split(UArray2m_height(pcl->array2), pcl->ntasks, task,
+		      &lo, &hi);
+	UArray2m_map_row_range(pcl->array2, lo, hi, (applyfun *) pcl->apply,
+			       pcl->cl);
+}
+
+static void col_range_task(int task, int thread, void *vcl)
+{
+	struct parallel_closure *pcl = vcl;
+	int lo, hi;
+	(void)thread;
+	Workers_split(UArray2m_width(pcl->array2), pcl->ntasks, task,
+		      &lo, &hi);
+	UArray2m_map_col_range(pcl->array2, lo, hi, (applyfun *) pcl->apply,
+			       pcl->cl);
+}
+
+// each task is a contiguous run of Morton indices, i.e. of memory
+static void morton_range_task(int task, int thread, void *vcl)
+{
+	struct parallel_closure *pcl = vcl;
+	long cells = UArray2m_cells(pcl->array2);
+	long lo = cells * task / pcl->ntasks;
+	long hi = cells * (task + 1) / pcl->ntasks;
+	(void)thread;
+	UArray2m_map_range(pcl->array2, lo, hi, (applyfun *) pcl->apply,
+			   pcl->cl);
+}
+
+// cuts the work into at most n tasks and lets the scheduler balance them
+static void parallel_map(A2 array2, A2Methods_applyfun apply, void *cl,
+			 int nthreads, long n, Sched_task *task)
+{
+	assert(nthreads >= 1);
+	int ntasks = nthreads * SCHED_TASKS_PER_THREAD;
+	struct parallel_closure pcl = { array2, apply, cl,
+		ntasks < n ? ntasks : (int)n };
+	Sched_run(Sched_shared(nthreads), pcl.ntasks, task, &pcl);
+}
+
+static void parallel_map_row_major(A2 array2, A2Methods_applyfun apply,
+				   void *cl, int nthreads)
+{
+	parallel_map(array2, apply, cl, nthreads, UArray2m_height(array2),
+		     row_range_task);
+}
+
+static void parallel_map_col_major(A2 array2, A2Methods_applyfun apply,
+				   void *cl, int nthreads)
+{
+	parallel_map(array2, apply, cl, nthreads, UArray2m_width(array2),
+		     col_range_task);
+}
+
+static void parallel_map_morton(A2 array2, A2Methods_applyfun apply,
+				void *cl, int nthreads)
+{
+	parallel_map(array2, apply, cl, nthreads, UArray2m_cells(array2),
+		     morton_range_task);
+}
+
+struct small_closure {
+	A2Methods_smallapplyfun *apply;
+	void *cl;
+};
+
+static void apply_small(int i, int j, UArray2m_T array2, void *elem, void *vcl)
+{
+	struct small_closure *cl = vcl;
+	(void)i;
+	(void)j;
+	(void)array2;
+	cl->apply(elem, cl->cl);
+}
+
+static void small_map_row_major(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+	struct small_closure mycl = { apply, cl };
+	UArray2m_map_row_major(a2, apply_small, &mycl);
+}
+
+static void small_map_col_major(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+	struct small_closure mycl = { apply, cl };
+	UArray2m_map_col_major(a2, apply_small, &mycl);
+}
+
+static void small_map_morton(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+	struct small_closure mycl = { apply, cl };
+	UArray2m_map(a2, apply_small, &mycl);
+}
+
+static struct A2Methods_T uarray2_methods_morton_struct = {
+	new,
+	new_with_blocksize,
+	a2free,
+	width,
+	height,
+	size,
+	blocksize,
+	at,
+	map_row_major,
+	map_col_major,
+	NULL,			// map_block_major
+	map_morton,		// map_default
+	small_map_row_major,
+	small_map_col_major,
+	NULL,			// small_map_block_major
+	small_map_morton,	// small_map_default
+	parallel_map_row_major,
+	parallel_map_col_major,
+	NULL,			// parallel_map_block_major
+	parallel_map_morton,	// parallel_map_default
+	new_with_allocator,
+	map_row_spans,
+	NULL,			// map_block_spans
+};
+
+// finally the payoff: here is the exported pointer to the struct
+
+A2Methods_T uarray2_methods_morton = &uarray2_methods_morton_struct;
@@ -0,0 +1,10 @@
+#ifndef A2MORTON_INCLUDED
+#define A2MORTON_INCLUDED
+#include "a2methods.h"
+
+/* 2D arrays stored in Morton (Z-order); map_default visits cells in
+ * Morton order and blocksize is 1
+ */
+extern A2Methods_T uarray2_methods_morton;
+
+#endif
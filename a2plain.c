@@ -10,7 +10,10 @@
  */
 #include <string.h>
 #include <a2plain.h>
+#include "assert.h"
 #include "uarray2.h"
+#include "sched.h"
+#include "workers.h"
 
 /************************************************/
 /* Define a private version of each function in */
@@ -64,6 +67,19 @@ static A2Methods_UArray2 new_with_blocksize(int width, int height,
   return UArray2_new(width, height, size);
 }
 
+/*  new_with_allocator
+ *
+ *  Purpose: As new, taking the array's memory from alloc; blocksize is
+ *           ignored
+ *
+ */
+static A2Methods_UArray2 new_with_allocator(int width, int height, int size,
+                                            int blocksize, Alloc_T alloc)
+{
+  (void) blocksize;
+  return UArray2_new_in(width, height, size, alloc);
+}
+
 typedef void UArray2_applyfun(int i, int j, UArray2_T array2b, void *elem,
                               void *cl);
 /*  map_row_major
@@ -117,6 +133,89 @@ static void map_col_major(A2Methods_UArray2 uarray2,
   UArray2_map_col_major(uarray2, (UArray2_applyfun*)apply, cl);
 }
 
+/* Shared by every task of one parallel map; the rows or columns are cut
+   into ntasks bands that the scheduler balances among the threads */
+struct parallel_closure {
+  A2Methods_UArray2   array2;
+  A2Methods_applyfun *apply;
+  void               *cl;
+  int                 ntasks;
+};
+
+static void row_range_task(int task, int thread, void *vcl)
+{
+  struct parallel_closure *pcl = vcl;
+  int lo, hi;
+  (void)thread;
+  Workers_split(UArray2_height(pcl->array2), pcl->ntasks, task, &lo, &hi);
+  UArray2_map_row_range(pcl->array2, lo, hi,
+                        (UArray2_applyfun*)pcl->apply, pcl->cl);
+}
+
+static void col_range_task(int task, int thread, void *vcl)
+{
+  struct parallel_closure *pcl = vcl;
+  int lo, hi;
+  (void)thread;
+  Workers_split(UArray2_width(pcl->array2), pcl->ntasks, task, &lo, &hi);
+  UArray2_map_col_range(pcl->array2, lo, hi,
+                        (UArray2_applyfun*)pcl->apply, pcl->cl);
+}
+
+/* Cuts n rows or columns into at most SCHED_TASKS_PER_THREAD bands per
+   thread and runs them on the shared scheduler */
+static void parallel_map(A2Methods_UArray2 uarray2, A2Methods_applyfun apply,
+                         void *cl, int nthreads, int n, Sched_task *task)
+{
+  assert(nthreads >= 1);
+  int ntasks = nthreads * SCHED_TASKS_PER_THREAD;
+  struct parallel_closure pcl = { uarray2, apply, cl, ntasks < n ? ntasks : n };
+  Sched_run(Sched_shared(nthreads), pcl.ntasks, task, &pcl);
+}
+/*  parallel_map_row_major
+ *
+ *  Purpose:
+ *
+ *    Visits every cell like map_row_major, but splits the rows into bands
+ *    of consecutive rows that nthreads worker threads share out.
+ *
+ *  Parameters:
+ *
+ *    uarray2:  The array the apply function can perform operations on
+ *    apply:    The function called on each cell, possibly concurrently
+ *    cl:       Closure passed through to the apply function
+ *    nthreads: Number of threads to split the rows among
+ *
+ *  Returns: nothing
+ *
+ */
+static void parallel_map_row_major(A2Methods_UArray2 uarray2,
+                                   A2Methods_applyfun apply,
+                                   void *cl, int nthreads)
+{
+  parallel_map(uarray2, apply, cl, nthreads, UArray2_height(uarray2),
+               row_range_task);
+}
+/*  parallel_map_col_major
+ *
+ *  Purpose:
+ *
+ *    Visits every cell like map_col_major, but splits the columns into
+ *    bands of consecutive columns that nthreads worker threads share out.
+ *
+ *  Parameters: as for parallel_map_row_major
+ *
+ *  Returns: nothing
+ *
+ */
+static void parallel_map_col_major(A2Methods_UArray2 uarray2,
+                                   A2Methods_applyfun apply,
+                                   void *cl, int nthreads)
+{
+  parallel_map(uarray2, apply, cl, nthreads, UArray2_width(uarray2),
+               col_range_task);
+}
+
 struct small_closure {
   A2Methods_smallapplyfun *apply;
   void                    *cl;
@@ -315,6 +414,21 @@ static A2Methods_Object *at(A2Methods_UArray2 array2, int col, int row)
   return UArray2_at(array2, col, row);
 }
 
+typedef void UArray2_spanfun(int i, int j, int n, UArray2_T array2,
+                             void *first, void *cl);
+/*  map_row_spans
+ *
+ *  Purpose: Visits the array row by row, calling apply once per row, as
+ *           each row is one contiguous run
+ *
+ */
+static void map_row_spans(A2Methods_UArray2 uarray2,
+                          A2Methods_spanfun apply,
+                          void *cl)
+{
+  UArray2_map_row_spans(uarray2, (UArray2_spanfun*)apply, cl);
+}
+
 static struct A2Methods_T uarray2_methods_plain_struct = {
   new,
   new_with_blocksize,
@@ -332,6 +446,13 @@ static struct A2Methods_T uarray2_methods_plain_struct = {
   small_map_col_major,
   NULL,           // small_map_block_major
   small_map_row_major, // small_map_default
+  parallel_map_row_major,
+  parallel_map_col_major,
+  NULL,           // parallel_map_block_major
+  parallel_map_row_major, // parallel_map_default
+  new_with_allocator,
+  map_row_spans,
+  NULL,           // map_block_spans
 };
 
 // finally the payoff: here is the exported pointer to the struct
@@ -0,0 +1,155 @@
+/*
+ *     a2sim.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Instrumented A2Methods: each function of the record hands its work
+ *     to the methods being instrumented, after telling the cache
+ *     simulator which cell it touches. Maps do this by visiting each cell
+ *     through a closure that records it before calling the client's apply.
+ *     Functions that do not touch cells (new, free, width and so on) are
+ *     copied from the instrumented methods unchanged.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stddef.h>
+#include "assert.h"
+#include "a2sim.h"
+
+#define A2 A2Methods_UArray2
+
+static struct A2Methods_T instrumented;
+static A2Methods_T inner;               /* the methods instrumented */
+static Cachesim_T sim;
+
+/* A client's apply function, one of three kinds, with its closure */
+struct Visit {
+        A2Methods_applyfun *apply;
+        A2Methods_smallapplyfun *smallApply;
+        A2Methods_spanfun *spanApply;
+        void *cl;
+        int size;
+};
+
+static void visit(int i, int j, A2 array2, A2Methods_Object *cell, void *cl)
+{
+        struct Visit *v = cl;
+        Cachesim_access(sim, cell, v->size);
+        v->apply(i, j, array2, cell, v->cl);
+}
+
+static void visit_small(A2Methods_Object *cell, void *cl)
+{
+        struct Visit *v = cl;
+        Cachesim_access(sim, cell, v->size);
+        v->smallApply(cell, v->cl);
+}
+
+static void visit_span(int i, int j, int n, A2 array2,
+                       A2Methods_Object *first, void *cl)
+{
+        struct Visit *v = cl;
+        Cachesim_access(sim, first, n * v->size);
+        v->spanApply(i, j, n, array2, first, v->cl);
+}
+
+static A2Methods_Object *at(A2 array2, int i, int j)
+{
+        A2Methods_Object *cell = inner->at(array2, i, j);
+        Cachesim_access(sim, cell, inner->size(array2));
+        return cell;
+}
+
+/*  run_map, run_small_map, run_span_map
+ *
+ *  Purpose: Run one of the instrumented methods' maps with the client's
+ *           apply function wrapped so that each visit is recorded
+ */
+static void run_map(A2Methods_mapfun *map, A2 array2,
+                    A2Methods_applyfun apply, void *cl)
+{
+        struct Visit v = { apply, NULL, NULL, cl, inner->size(array2) };
+        map(array2, visit, &v);
+}
+
+static void run_small_map(A2Methods_smallmapfun *map, A2 array2,
+                          A2Methods_smallapplyfun apply, void *cl)
+{
+        struct Visit v = { NULL, apply, NULL, cl, inner->size(array2) };
+        map(array2, visit_small, &v);
+}
+
+static void run_span_map(A2Methods_spanmapfun *map, A2 array2,
+                         A2Methods_spanfun apply, void *cl)
+{
+        struct Visit v = { NULL, NULL, apply, cl, inner->size(array2) };
+        map(array2, visit_span, &v);
+}
+
+/* The map, small map and parallel map of one order. A parallel map visits
+   every cell exactly once in an order of its own choosing, so running the
+   serial map satisfies it */
+#define ORDER(NAME)                                                     \
+static void map_##NAME(A2 array2, A2Methods_applyfun apply, void *cl)   \
+{                                                                       \
+        run_map(inner->map_##NAME, array2, apply, cl);                  \
+}                                                                       \
+static void small_map_##NAME(A2 array2,                                 \
+                             A2Methods_smallapplyfun apply, void *cl)   \
+{                                                                       \
+        run_small_map(inner->small_map_##NAME, array2, apply, cl);      \
+}                                                                       \
+static void parallel_map_##NAME(A2 array2, A2Methods_applyfun apply,    \
+                                void *cl, int nthreads)                 \
+{                                                                       \
+        assert(nthreads >= 1);                                          \
+        run_map(inner->map_##NAME, array2, apply, cl);                  \
+}
+
+ORDER(row_major)
+ORDER(col_major)
+ORDER(block_major)
+ORDER(default)
+
+#undef ORDER
+
+static void map_row_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+        run_span_map(inner->map_row_spans, array2, apply, cl);
+}
+
+static void map_block_spans(A2 array2, A2Methods_spanfun apply, void *cl)
+{
+        run_span_map(inner->map_block_spans, array2, apply, cl);
+}
+
+/* Points an instrumented function pointer at its wrapper, or leaves it
+   NULL if the instrumented methods lack it */
+#define WRAP(FIELD, WRAPPER) \
+        instrumented.FIELD = methods->FIELD != NULL ? WRAPPER : NULL
+
+A2Methods_T A2sim_methods(A2Methods_T methods, Cachesim_T simulator)
+{
+        assert(methods != NULL && simulator != NULL);
+        inner = methods;
+        sim = simulator;
+        instrumented = *methods;
+        instrumented.at = at;
+        WRAP(map_row_major, map_row_major);
+        WRAP(map_col_major, map_col_major);
+        WRAP(map_block_major, map_block_major);
+        WRAP(map_default, map_default);
+        WRAP(small_map_row_major, small_map_row_major);
+        WRAP(small_map_col_major, small_map_col_major);
+        WRAP(small_map_block_major, small_map_block_major);
+        WRAP(small_map_default, small_map_default);
+        WRAP(parallel_map_row_major, parallel_map_row_major);
+        WRAP(parallel_map_col_major, parallel_map_col_major);
+        WRAP(parallel_map_block_major, parallel_map_block_major);
+        WRAP(parallel_map_default, parallel_map_default);
+        WRAP(map_row_spans, map_row_spans);
+        WRAP(map_block_spans, map_block_spans);
+        return &instrumented;
+}
+
+#undef WRAP
+#undef A2
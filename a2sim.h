@@ -0,0 +1,16 @@
+#ifndef A2SIM_INCLUDED
+#define A2SIM_INCLUDED
+#include "a2methods.h"
+#include "cachesim.h"
+
+/* returns methods that work on the same arrays as 'methods', but pass the
+ * address of every cell that at() returns and every map visits to 'sim'.
+ * Parallel maps run on the calling thread, so the stream stays in order,
+ * and spans are passed on as one access per run.
+ *
+ * There is one such record: each call re-targets it, so it instruments
+ * only the latest methods and simulator given
+ */
+extern A2Methods_T A2sim_methods(A2Methods_T methods, Cachesim_T sim);
+
+#endif
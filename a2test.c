@@ -4,6 +4,7 @@
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2morton.h"
 
 
 #define W 13
@@ -120,6 +121,98 @@ static inline void copy_unsigned(A2Methods_T methods, A2 a,
         *p = n;
 }
 
+static void store_position(int i, int j, A2 a, void *elem, void *cl)
+{
+        (void)a;
+        (void)cl;
+        unsigned *p = elem;
+        *p = 1000 * i + j;
+}
+
+static void parallel_maps_cover_every_cell()
+{
+        A2Methods_parallelmapfun *maps[] = {
+                methods->parallel_map_row_major,
+                methods->parallel_map_col_major,
+                methods->parallel_map_block_major,
+                methods->parallel_map_default
+        };
+        A2Methods_mapfun *serial[] = {
+                methods->map_row_major,
+                methods->map_col_major,
+                methods->map_block_major,
+                methods->map_default
+        };
+        A2 array = methods->new_with_blocksize(W, H, sizeof(unsigned), BS);
+        for (int m = 0; m < 4; m++) {
+                assert((maps[m] == NULL) == (serial[m] == NULL));
+                if (maps[m] == NULL) {
+                        continue;
+                }
+                for (int nthreads = 1; nthreads <= 4; nthreads += 3) {
+                        for (int i = 0; i < W; i++) {
+                                for (int j = 0; j < H; j++) {
+                                        copy_unsigned(methods, array, i, j, 0);
+                                }
+                        }
+                        maps[m](array, store_position, NULL, nthreads);
+                        for (int i = 0; i < W; i++) {
+                                for (int j = 0; j < H; j++) {
+                                        check(array, i, j, 1000 * i + j);
+                                }
+                        }
+                }
+        }
+        methods->free(&array);
+}
+
+/* Where the next row span should start, and the cells seen so far */
+struct span_check {
+        int nextCol, nextRow;
+        int inOrder;
+        int cells;
+};
+
+static void check_span(int i, int j, int n, A2 a, void *first, void *cl)
+{
+        struct span_check *sc = cl;
+        int size = methods->size(a);
+        assert(n >= 1 && i + n <= W);
+        for (int k = 0; k < n; k++) {
+                unsigned *p = (unsigned *)((char *)first + k * size);
+                assert((void *)p == methods->at(a, i + k, j));
+                assert(*p == (unsigned)(1000 * (i + k) + j));
+        }
+        if (sc->inOrder) {
+                assert(i == sc->nextCol && j == sc->nextRow);
+                sc->nextCol = i + n < W ? i + n : 0;
+                sc->nextRow = i + n < W ? j : j + 1;
+        }
+        sc->cells += n;
+}
+
+static void span_maps_cover_every_cell()
+{
+        A2 array = methods->new_with_blocksize(W, H, sizeof(unsigned), BS);
+        for (int i = 0; i < W; i++) {
+                for (int j = 0; j < H; j++) {
+                        copy_unsigned(methods, array, i, j, 1000 * i + j);
+                }
+        }
+        if (methods->map_block_spans == NULL) {
+                assert(methods->map_block_major == NULL);
+        } else {
+                struct span_check sc = { 0, 0, 0, 0 };
+                methods->map_block_spans(array, check_span, &sc);
+                assert(sc.cells == W * H);
+        }
+        assert(methods->map_row_spans != NULL);
+        struct span_check sc = { 0, 0, 1, 0 };
+        methods->map_row_spans(array, check_span, &sc);
+        assert(sc.cells == W * H);
+        methods->free(&array);
+}
+
 static void test_methods(A2Methods_T methods_under_test) 
 {
         methods = methods_under_test;
@@ -158,6 +251,8 @@ static void test_methods(A2Methods_T methods_under_test)
                 }
         }
         double_row_major_plus();
+        parallel_maps_cover_every_cell();
+        span_maps_cover_every_cell();
         methods->free(&array);
 }
 
@@ -167,6 +262,7 @@ int main(int argc, char *argv[])
         (void)argv;
         test_methods(uarray2_methods_plain);
         test_methods(uarray2_methods_blocked);
+        test_methods(uarray2_methods_morton);
         printf("Passed.\n");  /* only if we reach this point without
                                * assertion failure
                                */
@@ -0,0 +1,290 @@
+/*
+ *     alloc.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the heap and arena allocators. An arena is a list
+ *     of chunks, each a header followed by its memory. Allocation bumps
+ *     the free pointer of the current chunk, moving on to the next chunk
+ *     (or a new one at the end of the list) when the request does not fit.
+ *     Resetting makes the first chunk current again; the others are
+ *     emptied as allocation reaches them.
+ *
+ *     A huge-page arena maps each chunk itself, rounded up to whole 2MB
+ *     pages, trying MAP_HUGETLB first and then an ordinary mapping aligned
+ *     to 2MB and advised with MADV_HUGEPAGE. If mapping fails altogether the
+ *     chunk comes from the heap like any other.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include "assert.h"
+#include "mem.h"
+#include "alloc.h"
+
+#define T Alloc_T
+
+/* Chunk size when the caller does not pick one */
+#define DEFAULT_CHUNK (1024 * 1024)
+
+/* Size of the huge pages huge-page arenas ask for */
+#define HUGE_PAGE (2L * 1024 * 1024)
+
+/* Where a chunk's memory came from */
+enum Backing { HEAP, HUGETLB, ADVISED, SMALL };
+
+struct Chunk {
+        struct Chunk *next;
+        char *avail;            /* first free byte */
+        char *limit;            /* one past the last byte */
+        long mapped;            /* bytes mapped for the chunk, 0 if heap */
+        enum Backing backing;
+};
+
+struct T {
+        long chunkBytes;
+        int huge;               /* nonzero to map chunks in huge pages */
+        struct Chunk *first, *last;
+        struct Chunk *current;  /* NULL until the first allocation */
+};
+
+/* Rounds n up to a multiple of ALLOC_ALIGN */
+static inline uintptr_t align_up(uintptr_t n)
+{
+        return (n + ALLOC_ALIGN - 1) & ~(uintptr_t)(ALLOC_ALIGN - 1);
+}
+
+/* Returns the first aligned byte of a chunk's memory */
+static inline char *chunk_start(struct Chunk *chunk)
+{
+        return (char *)align_up((uintptr_t)(chunk + 1));
+}
+
+/*  map_huge
+ *
+ *  Purpose: Maps len bytes (a multiple of HUGE_PAGE) in huge pages if the
+ *           system will give them, and otherwise on a 2MB boundary with
+ *           advice to use transparent huge pages
+ *
+ *  Parameters: length of the mapping; where to store how it is backed
+ *
+ *  Returns: The mapping, or NULL if nothing could be mapped
+ */
+static char *map_huge(long len, enum Backing *backing)
+{
+#ifdef MAP_HUGETLB
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+        flags |= 21 << MAP_HUGE_SHIFT;          /* 2MB, not the default */
+#endif
+        void *pages = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (pages != MAP_FAILED) {
+                *backing = HUGETLB;
+                return pages;
+        }
+#endif
+
+        /* Over-map by a huge page, then trim to a 2MB-aligned range */
+        char *raw = mmap(NULL, len + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+                return NULL;
+        }
+        char *start = (char *)(((uintptr_t)raw + HUGE_PAGE - 1) &
+                               ~(uintptr_t)(HUGE_PAGE - 1));
+        if (start > raw) {
+                munmap(raw, start - raw);
+        }
+        if (raw + HUGE_PAGE > start) {
+                munmap(start + len, raw + HUGE_PAGE - start);
+        }
+
+        *backing = SMALL;
+#ifdef MADV_HUGEPAGE
+        if (madvise(start, len, MADV_HUGEPAGE) == 0) {
+                *backing = ADVISED;
+        }
+#endif
+        return start;
+}
+
+/*  new_chunk
+ *
+ *  Purpose: Adds an empty chunk of at least nbytes to the end of the
+ *           arena's list
+ *
+ *  Returns: The chunk
+ */
+static struct Chunk *new_chunk(T arena, long nbytes)
+{
+        long bytes = nbytes > arena->chunkBytes ? nbytes : arena->chunkBytes;
+        long total = sizeof(struct Chunk) + ALLOC_ALIGN + bytes;
+        struct Chunk *chunk = NULL;
+        enum Backing backing = HEAP;
+
+        if (arena->huge) {
+                total = (total + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+                chunk = (struct Chunk *)map_huge(total, &backing);
+        }
+        if (chunk == NULL) {
+                total = sizeof(struct Chunk) + ALLOC_ALIGN + bytes;
+                chunk = ALLOC(total);
+                backing = HEAP;
+        }
+        chunk->next = NULL;
+        chunk->avail = chunk_start(chunk);
+        chunk->limit = (char *)chunk + total;
+        chunk->mapped = backing == HEAP ? 0 : total;
+        chunk->backing = backing;
+        if (arena->last == NULL) {
+                arena->first = chunk;
+        } else {
+                arena->last->next = chunk;
+        }
+        arena->last = chunk;
+        return chunk;
+}
+
+void *Alloc_alloc(T alloc, long nbytes)
+{
+        assert(nbytes > 0);
+        if (alloc == NULL) {
+                return CALLOC(1, nbytes);
+        }
+
+        nbytes = align_up(nbytes);
+        struct Chunk *chunk = alloc->current;
+        if (chunk == NULL) {
+                chunk = alloc->first;
+                if (chunk != NULL) {
+                        chunk->avail = chunk_start(chunk);
+                }
+        }
+        while (chunk != NULL && chunk->limit - chunk->avail < nbytes) {
+                chunk = chunk->next;
+                if (chunk != NULL) {
+                        chunk->avail = chunk_start(chunk);
+                }
+        }
+        if (chunk == NULL) {
+                chunk = new_chunk(alloc, nbytes);
+        }
+        alloc->current = chunk;
+
+        void *ptr = chunk->avail;
+        chunk->avail += nbytes;
+        return ptr;
+}
+
+void Alloc_release(T alloc, void *ptr)
+{
+        if (alloc == NULL) {
+                FREE(ptr);
+        }
+}
+
+T Alloc_arena_new(long chunkBytes)
+{
+        assert(chunkBytes >= 0);
+        T arena;
+        NEW(arena);
+        arena->chunkBytes = chunkBytes > 0 ? chunkBytes : DEFAULT_CHUNK;
+        arena->huge = 0;
+        arena->first = arena->last = arena->current = NULL;
+        return arena;
+}
+
+T Alloc_arena_new_huge(long chunkBytes)
+{
+        T arena = Alloc_arena_new(chunkBytes > 0 ? chunkBytes : HUGE_PAGE);
+        arena->huge = 1;
+        return arena;
+}
+
+/*  advised_huge_bytes
+ *
+ *  Purpose: Adds up the transparent huge pages the kernel has put behind
+ *           the arena's advised chunks, from /proc/self/smaps
+ *
+ *  Returns: The number of bytes, or 0 if smaps cannot be read
+ */
+static long advised_huge_bytes(T arena)
+{
+        FILE *fp = fopen("/proc/self/smaps", "r");
+        if (fp == NULL) {
+                return 0;
+        }
+
+        char line[512];
+        long bytes = 0;
+        int inChunk = 0;
+        while (fgets(line, sizeof(line), fp) != NULL) {
+                unsigned long start, end;
+                long kB;
+                if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+                        /* A new mapping: is it one of the advised chunks? */
+                        inChunk = 0;
+                        for (struct Chunk *c = arena->first; c != NULL;
+                             c = c->next) {
+                                uintptr_t lo = (uintptr_t)c;
+                                if (c->backing == ADVISED && lo < end &&
+                                    lo + c->mapped > start) {
+                                        inChunk = 1;
+                                }
+                        }
+                } else if (inChunk && sscanf(line, "AnonHugePages: %ld kB",
+                                             &kB) == 1) {
+                        bytes += kB * 1024;
+                }
+        }
+        fclose(fp);
+        return bytes;
+}
+
+struct Alloc_pages Alloc_pages(T alloc)
+{
+        struct Alloc_pages pages = { 0, 0, 0, 0 };
+        if (alloc == NULL) {
+                return pages;
+        }
+
+        for (struct Chunk *c = alloc->first; c != NULL; c = c->next) {
+                long bytes = c->limit - (char *)c;
+                switch (c->backing) {
+                case HUGETLB: pages.hugetlb += bytes; break;
+                case ADVISED: pages.advised += bytes; break;
+                default:      pages.small += bytes;   break;
+                }
+        }
+        if (pages.advised > 0) {
+                /* smaps may count neighbouring memory in the same mapping */
+                long huge = advised_huge_bytes(alloc);
+                pages.advisedHuge = huge < pages.advised ? huge
+                                                         : pages.advised;
+        }
+        return pages;
+}
+
+void Alloc_arena_reset(T arena)
+{
+        assert(arena != NULL);
+        arena->current = NULL;
+}
+
+void Alloc_arena_free(T *arena)
+{
+        assert(arena != NULL && *arena != NULL);
+        struct Chunk *chunk = (*arena)->first;
+        while (chunk != NULL) {
+                struct Chunk *next = chunk->next;
+                if (chunk->mapped > 0) {
+                        munmap(chunk, chunk->mapped);
+                } else {
+                        FREE(chunk);
+                }
+                chunk = next;
+        }
+        FREE(*arena);
+}
@@ -0,0 +1,71 @@
+/*
+ *     alloc.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for the allocators 2D arrays can take their memory from.
+ *     A NULL Alloc_T stands for the Hanson heap (mem.h), where every
+ *     allocation is freed on its own. An arena hands out memory by bumping
+ *     a pointer through large chunks and gives it all back at once, so an
+ *     image, its transformed copy and their bookkeeping come from one
+ *     region and are released in constant time. A huge-page arena maps
+ *     its chunks in 2MB pages, so that walking down a column of a large
+ *     image does not miss the TLB at every step.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef ALLOC_INCLUDED
+#define ALLOC_INCLUDED
+
+#define T Alloc_T
+typedef struct T *T;
+
+/* Alignment of every arena allocation: one cache line */
+#define ALLOC_ALIGN 64
+
+/* returns nbytes of memory from alloc: zeroed if alloc is NULL (the heap),
+ * uninitialized and ALLOC_ALIGN-aligned if it is an arena. nbytes < 1 is
+ * a checked run-time error.
+ */
+extern void *Alloc_alloc(T alloc, long nbytes);
+
+/* gives back memory from Alloc_alloc: frees it if alloc is NULL, and does
+ * nothing for an arena, whose memory goes back only when it is reset
+ */
+extern void Alloc_release(T alloc, void *ptr);
+
+/* creates an arena that gets memory from the heap in chunks of at least
+ * chunkBytes (0 picks a default); larger requests get a chunk of their own
+ */
+extern T Alloc_arena_new(long chunkBytes);
+
+/* like Alloc_arena_new, but the chunks are mapped in 2MB pages: explicit
+ * huge pages (MAP_HUGETLB) if the system has any reserved, otherwise
+ * ordinary pages with MADV_HUGEPAGE advice so that the kernel can back them
+ * with transparent huge pages, otherwise ordinary pages
+ */
+extern T Alloc_arena_new_huge(long chunkBytes);
+
+/* Bytes of an allocator's chunks by how they are backed */
+struct Alloc_pages {
+        long hugetlb;           /* mapped with MAP_HUGETLB */
+        long advised;           /* mapped with MADV_HUGEPAGE advice */
+        long advisedHuge;       /* of those, now in transparent huge pages */
+        long small;             /* on ordinary pages only */
+};
+
+/* returns how the memory alloc has taken so far is backed; all zero for
+ * the heap. advisedHuge comes from /proc/self/smaps and is 0 where that
+ * cannot be read.
+ */
+extern struct Alloc_pages Alloc_pages(T alloc);
+
+/* gives back everything allocated from the arena, keeping its chunks for
+ * later allocations; takes constant time
+ */
+extern void Alloc_arena_reset(T arena);
+
+/* frees the arena's chunks and *arena, and sets *arena to NULL */
+extern void Alloc_arena_free(T *arena);
+
+#undef T
+#endif
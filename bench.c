@@ -0,0 +1,411 @@
+/*
+ *     bench.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Benchmark harness for the transforms. For every image shape asked
+ *     for, it fills a synthetic image in each A2Methods layout and times
+ *     every transform through every way of traversing that layout: each
+ *     map the layout has (one apply call per pixel), the tile engine, and,
+ *     for the plain layout, the specialized row and column kernels. Each
+ *     case gets warmup runs and then timed repetitions, optionally with
+ *     the caches flushed before each one, and is reported as one CSV row
+ *     or JSON object with the median, 95th percentile, minimum and
+ *     standard deviation of the wall-clock time per pixel, after
+ *     outlying repetitions are rejected (see cputiming.h). With -arena
+ *     the images come from one arena, reset after each layout so that the
+ *     next one reuses its chunks.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mem.h>
+#include "assert.h"
+#include "a2methods.h"
+#include "alloc.h"
+#include "d4.h"
+#include "tiletrans.h"
+#include "spectrans.h"
+#include "blocktune.h"
+#include "cputiming.h"
+#include "sched.h"
+#include "harness.h"
+
+/* Largest buffer swept to flush the caches */
+#define MAX_FLUSH (1024L * 1024 * 1024)
+
+/* A traversal: how a case moves the pixels */
+enum Kind { MAP, TILES, SPECIALIZED };
+
+struct Traversal {
+        const char *name;
+        enum Kind kind;
+        int mapIndex;           /* for MAP and SPECIALIZED: which map */
+};
+
+/* Maps, in the order of A2Methods_T: 0 row, 1 col, 2 block, 3 default */
+static const struct Traversal traversals[] = {
+        { "row-major",   MAP,         0 },
+        { "col-major",   MAP,         1 },
+        { "block-major", MAP,         2 },
+        { "default",     MAP,         3 },
+        { "tiles",       TILES,       0 },
+        { "spec-row",    SPECIALIZED, 0 },
+        { "spec-col",    SPECIALIZED, 1 },
+};
+#define TRAVERSALS (int)(sizeof(traversals) / sizeof(traversals[0]))
+
+/* What to run, from the command line */
+struct Options {
+        struct Harness_cases cases;
+        int warmup, reps;
+        int cold;
+        int json;
+        int nthreads;
+        Alloc_T arena;          /* NULL for the heap */
+};
+
+/* State for one timed case */
+struct Case {
+        struct Harness_copy copy;       /* methods, destination, transform */
+        A2Methods_UArray2 source;
+        const struct Traversal *traversal;
+        int d4;
+        Sched_T sched;
+        int nthreads;
+        char *flush;            /* NULL unless the caches are flushed */
+        long flushBytes;
+};
+
+/* usage
+      Purpose: Prints how to run the harness and exits with status 1
+   Parameters: Name the program was run as
+      Returns: None
+*/
+static void usage(const char *progname)
+{
+        fprintf(stderr,
+                "Usage: %s " HARNESS_USAGE " "
+                "[-warmup N] [-reps N] [-threads N] [-cold] [-arena] "
+                "[-json]\n"
+                HARNESS_D4_USAGE,
+                progname);
+        exit(1);
+}
+
+/* default_sizes
+      Purpose: Fills in the default shapes: about 0.06, 1 and 4 megapixels,
+               each square, 4:3, 16:9 and 1:4 (tall)
+   Parameters: Cases to fill in
+      Returns: None
+*/
+static void default_sizes(struct Harness_cases *cases)
+{
+        static const double pixels[] = { 65536, 1048576, 4194304 };
+        static const int aspect[][2] = { {1, 1}, {4, 3}, {16, 9}, {1, 4} };
+        cases->shapes = 0;
+        for (int p = 0; p < 3; p++) {
+                for (int a = 0; a < 4; a++) {
+                        double unit = sqrt(pixels[p] /
+                                           (aspect[a][0] * aspect[a][1]));
+                        cases->widths[cases->shapes] = unit * aspect[a][0];
+                        cases->heights[cases->shapes] = unit * aspect[a][1];
+                        cases->shapes++;
+                }
+        }
+}
+
+/* run_case
+      Purpose: Moves every pixel of the case's source once
+   Parameters: The case
+      Returns: None
+*/
+static void run_case(struct Case *c)
+{
+        const struct Traversal *t = c->traversal;
+        A2Methods_T methods = c->copy.methods;
+        A2Methods_mapfun *maps[] = {
+                methods->map_row_major, methods->map_col_major,
+                methods->map_block_major, methods->map_default
+        };
+        A2Methods_parallelmapfun *parallelMaps[] = {
+                methods->parallel_map_row_major,
+                methods->parallel_map_col_major,
+                methods->parallel_map_block_major,
+                methods->parallel_map_default
+        };
+
+        switch (t->kind) {
+        case MAP:
+                if (c->nthreads > 1) {
+                        parallelMaps[t->mapIndex](c->source,
+                                                  Harness_copy_cell, &c->copy,
+                                                  c->nthreads);
+                } else {
+                        maps[t->mapIndex](c->source, Harness_copy_cell,
+                                          &c->copy);
+                }
+                break;
+        case TILES:
+                Tiletrans_apply(methods, c->source, c->copy.dest,
+                                c->copy.transform, 0, c->sched);
+                break;
+        case SPECIALIZED:
+                Spectrans_apply(methods, maps[t->mapIndex], c->source,
+                                c->copy.dest, c->d4, c->sched);
+                break;
+        }
+}
+
+/* supported
+      Purpose: Says whether a layout has a traversal
+   Parameters: Methods of the layout, the traversal
+      Returns: Nonzero if the traversal can run on the layout
+*/
+static int supported(A2Methods_T methods, const struct Traversal *t)
+{
+        A2Methods_mapfun *maps[] = {
+                methods->map_row_major, methods->map_col_major,
+                methods->map_block_major, methods->map_default
+        };
+        switch (t->kind) {
+        case MAP:
+                return maps[t->mapIndex] != NULL;
+        case TILES:
+                return 1;
+        case SPECIALIZED:
+                return maps[t->mapIndex] != NULL &&
+                       Spectrans_supports(methods, maps[t->mapIndex]);
+        }
+        return 0;
+}
+
+/* flush_caches
+      Purpose: Writes a buffer larger than the last level cache so that
+               the next run starts with none of the images cached
+   Parameters: The case
+      Returns: None
+*/
+static void flush_caches(struct Case *c)
+{
+        for (long i = 0; i < c->flushBytes; i += 64) {
+                c->flush[i]++;
+        }
+}
+
+/* time_case
+      Purpose: Runs the warmup runs and the timed repetitions of a case,
+               on the wall clock so that threaded runs are not charged
+               for every thread
+   Parameters: The case, options, where to store the summary of the
+               repetitions' times in nanoseconds
+      Returns: None
+*/
+static void time_case(struct Case *c, struct Options *opts,
+                      struct CPUTime_Stats *stats)
+{
+        double times[opts->reps];
+        CPUTime_T timer = CPUTime_New();
+        for (int i = 0; i < opts->warmup; i++) {
+                if (c->flush != NULL) {
+                        flush_caches(c);
+                }
+                run_case(c);
+        }
+        for (int i = 0; i < opts->reps; i++) {
+                struct CPUTime_Sample sample;
+                if (c->flush != NULL) {
+                        flush_caches(c);
+                }
+                CPUTime_Start(timer);
+                run_case(c);
+                CPUTime_Sample(timer, &sample);
+                times[i] = sample.wall;
+        }
+        CPUTime_Free(&timer);
+        CPUTime_Summarize(times, opts->reps, stats);
+}
+
+/* report
+      Purpose: Prints one case as a CSV row or a JSON object
+   Parameters: Options, layout and traversal names, D4 element, shape, cell
+               size, summary of the times in nanoseconds, whether this is
+               the first case printed
+      Returns: None
+*/
+static void report(struct Options *opts, const char *layout,
+                   const char *traversal, int d4, int width, int height,
+                   int cell, struct CPUTime_Stats *stats, int first)
+{
+        double pixels = (double)width * height;
+        const char *cache = opts->cold ? "cold" : "warm";
+
+        if (opts->json) {
+                printf("%s\n  {\"layout\": \"%s\", \"traversal\": \"%s\", "
+                       "\"transform\": \"%s\", \"d4\": %d, \"width\": %d, "
+                       "\"height\": %d, \"cell\": %d, \"cache\": \"%s\", "
+                       "\"threads\": %d, \"reps\": %d, \"kept\": %d, "
+                       "\"median_ns_per_pixel\": %.3f, "
+                       "\"p95_ns_per_pixel\": %.3f, "
+                       "\"min_ns_per_pixel\": %.3f, "
+                       "\"stddev_ns_per_pixel\": %.3f}",
+                       first ? "[" : ",", layout, traversal, D4_id(d4), d4,
+                       width, height, cell, cache, opts->nthreads,
+                       stats->runs, stats->kept, stats->median / pixels,
+                       stats->p95 / pixels, stats->min / pixels,
+                       stats->stddev / pixels);
+        } else {
+                printf("%s,%s,%s,%d,%d,%d,%d,%s,%d,%d,%d,"
+                       "%.3f,%.3f,%.3f,%.3f\n",
+                       layout, traversal, D4_id(d4), d4, width, height,
+                       cell, cache, opts->nthreads, stats->runs, stats->kept,
+                       stats->median / pixels, stats->p95 / pixels,
+                       stats->min / pixels, stats->stddev / pixels);
+        }
+        fflush(stdout);
+}
+
+/* run_all
+      Purpose: Times every layout, traversal and transform asked for on one
+               image shape and cell size
+   Parameters: Options, shape, cell size, flush buffer (NULL if warm),
+               whether nothing has been printed yet
+      Returns: The updated "nothing printed yet" flag
+*/
+static int run_all(struct Options *opts, int width, int height, int cell,
+                   char *flush, long flushBytes, int first)
+{
+        struct CPUTime_Stats stats;
+        for (int l = 0; l < HARNESS_LAYOUTS; l++) {
+                if (!Harness_wants(&opts->cases, l)) {
+                        continue;
+                }
+                struct Case c;
+                A2Methods_T methods = *Harness_layouts[l].methods;
+                c.copy.methods = methods;
+                c.nthreads = opts->nthreads;
+                c.sched = opts->nthreads > 1 ? Sched_shared(opts->nthreads)
+                                             : NULL;
+                c.flush = flush;
+                c.flushBytes = flushBytes;
+                c.source = methods->new_with_allocator(width, height, cell,
+                                                       0, opts->arena);
+                Harness_fill(methods, c.source);
+
+                /* A destination of each orientation, made on first use */
+                A2Methods_UArray2 dests[2] = { NULL, NULL };
+                for (int d = 0; d < opts->cases.nd4s; d++) {
+                        c.d4 = opts->cases.d4s[d];
+                        c.copy.transform = D4_transformation(c.d4);
+                        int swaps = D4_swaps_dimensions(c.d4) != 0;
+                        if (dests[swaps] == NULL) {
+                                dests[swaps] = methods->new_with_allocator(
+                                        swaps ? height : width,
+                                        swaps ? width : height, cell, 0,
+                                        opts->arena);
+                                Harness_fill(methods, dests[swaps]);
+                        }
+                        c.copy.dest = dests[swaps];
+                        for (int t = 0; t < TRAVERSALS; t++) {
+                                c.traversal = &traversals[t];
+                                if (!supported(methods, c.traversal)) {
+                                        continue;
+                                }
+                                time_case(&c, opts, &stats);
+                                report(opts, Harness_layouts[l].name,
+                                       traversals[t].name, c.d4, width,
+                                       height, cell, &stats, first);
+                                first = 0;
+                        }
+                }
+                for (int s = 0; s < 2; s++) {
+                        if (dests[s] != NULL) {
+                                methods->free(&dests[s]);
+                        }
+                }
+                methods->free(&c.source);
+                if (opts->arena != NULL) {
+                        Alloc_arena_reset(opts->arena);
+                }
+        }
+        return first;
+}
+
+int main(int argc, char *argv[])
+{
+        struct Options opts;
+        Harness_defaults(&opts.cases);
+        default_sizes(&opts.cases);
+        opts.warmup = 1;
+        opts.reps = 5;
+        opts.cold = 0;
+        opts.json = 0;
+        opts.nthreads = 1;
+        opts.arena = NULL;
+
+        for (int i = 1; i < argc; i++) {
+                if (Harness_option(&opts.cases, argc, argv, &i)) {
+                        continue;
+                }
+                int more = i + 1 < argc;
+                if (strcmp(argv[i], "-warmup") == 0 && more) {
+                        opts.warmup = atoi(argv[++i]);
+                } else if (strcmp(argv[i], "-reps") == 0 && more) {
+                        opts.reps = atoi(argv[++i]);
+                } else if (strcmp(argv[i], "-threads") == 0 && more) {
+                        opts.nthreads = atoi(argv[++i]);
+                } else if (strcmp(argv[i], "-cold") == 0) {
+                        opts.cold = 1;
+                } else if (strcmp(argv[i], "-arena") == 0) {
+                        if (opts.arena == NULL) {
+                                opts.arena = Alloc_arena_new(0);
+                        }
+                } else if (strcmp(argv[i], "-json") == 0) {
+                        opts.json = 1;
+                } else {
+                        usage(argv[0]);
+                }
+        }
+        if (opts.reps < 1 || opts.warmup < 0 || opts.nthreads < 1 ||
+            !Harness_valid(&opts.cases)) {
+                usage(argv[0]);
+        }
+
+        /* Cold runs sweep twice the last level cache before every run */
+        char *flush = NULL;
+        long flushBytes = 0;
+        if (opts.cold) {
+                flushBytes = 2 * Blocktune_caches().llc;
+                if (flushBytes > MAX_FLUSH) {
+                        flushBytes = MAX_FLUSH;
+                }
+                flush = CALLOC(flushBytes, 1);
+        }
+
+        if (!opts.json) {
+                printf("layout,traversal,transform,d4,width,height,cell,"
+                       "cache,threads,reps,kept,median_ns_per_pixel,"
+                       "p95_ns_per_pixel,min_ns_per_pixel,"
+                       "stddev_ns_per_pixel\n");
+        }
+        int first = 1;
+        struct Harness_cases *cases = &opts.cases;
+        for (int s = 0; s < cases->shapes; s++) {
+                for (int k = 0; k < cases->ncells; k++) {
+                        first = run_all(&opts, cases->widths[s],
+                                        cases->heights[s], cases->cells[k],
+                                        flush, flushBytes, first);
+                }
+        }
+        if (opts.json) {
+                printf(first ? "[]\n" : "\n]\n");
+        }
+
+        FREE(flush);
+        if (opts.arena != NULL) {
+                Alloc_arena_free(&opts.arena);
+        }
+        return EXIT_SUCCESS;
+}
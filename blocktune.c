@@ -0,0 +1,270 @@
+/*
+ *     blocktune.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the blocksize auto-tuner. Candidates are the
+ *     blocksizes whose blocks fill about half of L1, of L2 or of a share of
+ *     the last level cache, plus the 64KB default and the powers of two in
+ *     between. Each is timed by transforming a test image that does not
+ *     fit in L2 with the tile engine; the fastest wins.
+ *
+ *     Tuning file entries are lines of
+ *         l1 l2 llc size d4 blocksize
+ *     so that a file shared by machines with different caches keeps an
+ *     answer for each.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "assert.h"
+#include "blocktune.h"
+#include "a2blocked.h"
+#include "uarray2b.h"
+#include "tiletrans.h"
+#include "cputiming.h"
+#include "d4.h"
+
+/* Where sysfs describes CPU 0's caches */
+#define CACHE_DIR "/sys/devices/system/cpu/cpu0/cache"
+
+/* Bytes of the test image */
+#define TEST_BYTES (8L * 1024 * 1024)
+
+/* Most candidates tried */
+#define MAX_CANDIDATES 16
+
+/* Timed runs per candidate; the fastest counts */
+#define RUNS 2
+
+/*  read_cache_file
+ *
+ *  Purpose: Reads one line of a cache description in sysfs
+ *
+ *  Parameters: cache index, file name, buffer and its size
+ *
+ *  Returns: 1 if the line was read, 0 if not
+ */
+static int read_cache_file(int index, const char *name, char *buf, int len)
+{
+        char path[128];
+        snprintf(path, sizeof(path), CACHE_DIR "/index%d/%s", index, name);
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) {
+                return 0;
+        }
+        int ok = fgets(buf, len, fp) != NULL;
+        fclose(fp);
+        return ok;
+}
+
+struct Blocktune_caches Blocktune_caches(void)
+{
+        struct Blocktune_caches caches = { 0, 0, 0 };
+        int llcLevel = 0;
+
+        for (int index = 0; index < 16; index++) {
+                char level[16], type[32], size[32];
+                if (!read_cache_file(index, "level", level, sizeof(level)) ||
+                    !read_cache_file(index, "type", type, sizeof(type)) ||
+                    !read_cache_file(index, "size", size, sizeof(size))) {
+                        break;
+                }
+                if (strncmp(type, "Instruction", 11) == 0) {
+                        continue;
+                }
+
+                /* Sizes read like "48K" or "32M" */
+                char *unit;
+                long bytes = strtol(size, &unit, 10);
+                if (*unit == 'K') {
+                        bytes *= 1024;
+                } else if (*unit == 'M') {
+                        bytes *= 1024 * 1024;
+                }
+
+                int lvl = atoi(level);
+                if (lvl == 1) {
+                        caches.l1 = bytes;
+                } else if (lvl == 2) {
+                        caches.l2 = bytes;
+                }
+                if (lvl >= llcLevel) {
+                        llcLevel = lvl;
+                        caches.llc = bytes;
+                }
+        }
+
+        if (caches.l1 <= 0) {
+                caches.l1 = 32 * 1024;
+        }
+        if (caches.l2 <= 0) {
+                caches.l2 = 256 * 1024;
+        }
+        if (caches.llc < caches.l2) {
+                caches.llc = caches.l2;
+        }
+        return caches;
+}
+
+const char *Blocktune_file(void)
+{
+        static char path[512];
+        const char *file = getenv("BLOCKTUNE_FILE");
+        if (file != NULL && *file != '\0') {
+                return file;
+        }
+        const char *home = getenv("HOME");
+        snprintf(path, sizeof(path), "%s/.blocktune",
+                 home != NULL ? home : ".");
+        return path;
+}
+
+/*  lookup
+ *
+ *  Purpose: Finds the tuned blocksize for a cell size and transform on
+ *           machines with these caches
+ *
+ *  Returns: The blocksize, or 0 if the file has none
+ */
+static int lookup(struct Blocktune_caches *caches, int size, int d4)
+{
+        FILE *fp = fopen(Blocktune_file(), "r");
+        if (fp == NULL) {
+                return 0;
+        }
+
+        long l1, l2, llc;
+        int entrySize, entryD4, blocksize, found = 0;
+        while (fscanf(fp, "%ld %ld %ld %d %d %d", &l1, &l2, &llc,
+                      &entrySize, &entryD4, &blocksize) == 6) {
+                if (l1 == caches->l1 && l2 == caches->l2 &&
+                    llc == caches->llc && entrySize == size &&
+                    entryD4 == d4 && blocksize > 1) {
+                        found = blocksize;      /* the latest entry wins */
+                }
+        }
+        fclose(fp);
+        return found;
+}
+
+/* Returns the largest blocksize whose blocks of cells of 'size' bytes fit
+   in 'bytes', and at least 2 */
+static int fitting_blocksize(long bytes, int size)
+{
+        int blocksize = sqrt((double)bytes / size);
+        return blocksize < 2 ? 2 : blocksize;
+}
+
+/* Adds blocksize to the n candidates unless it is already there */
+static int add_candidate(int *candidates, int n, int blocksize)
+{
+        for (int i = 0; i < n; i++) {
+                if (candidates[i] == blocksize) {
+                        return n;
+                }
+        }
+        if (n < MAX_CANDIDATES) {
+                candidates[n++] = blocksize;
+        }
+        return n;
+}
+
+/*  time_blocksize
+ *
+ *  Purpose: Times the tile engine applying d4 to a test image stored with
+ *           the given blocksize
+ *
+ *  Returns: The fastest of RUNS runs, in nanoseconds
+ */
+static double time_blocksize(int blocksize, int size, int d4, int side)
+{
+        /* The test image is square, so every d4 keeps its shape */
+        A2Methods_T methods = uarray2_methods_blocked;
+        A2Methods_UArray2 source = methods->new_with_blocksize(side, side,
+                                                               size,
+                                                               blocksize);
+        A2Methods_UArray2 dest = methods->new_with_blocksize(side, side,
+                                                             size,
+                                                             blocksize);
+
+        CPUTime_T timer = CPUTime_New();
+        double best = -1;
+        for (int run = 0; run <= RUNS; run++) {
+                CPUTime_Start(timer);
+                Tiletrans_apply(methods, source, dest, D4_transformation(d4),
+                                0, NULL);
+                double time = CPUTime_Stop(timer);
+                /* run 0 only touches the pages */
+                if (run > 0 && (best < 0 || time < best)) {
+                        best = time;
+                }
+        }
+        CPUTime_Free(&timer);
+        methods->free(&source);
+        methods->free(&dest);
+        return best;
+}
+
+/*  calibrate
+ *
+ *  Purpose: Times every candidate blocksize and returns the fastest
+ */
+static int calibrate(struct Blocktune_caches *caches, int size, int d4)
+{
+        int candidates[MAX_CANDIDATES];
+        int n = 0;
+        n = add_candidate(candidates, n, fitting_blocksize(caches->l1 / 2,
+                                                           size));
+        n = add_candidate(candidates, n, fitting_blocksize(caches->l2 / 2,
+                                                           size));
+        n = add_candidate(candidates, n, fitting_blocksize(caches->llc / 16,
+                                                           size));
+        n = add_candidate(candidates, n, UArray2b_blocksize_64K(size) < 2 ?
+                                         2 : UArray2b_blocksize_64K(size));
+        for (int b = 8; b <= 1024 && (long)b * b * size <= caches->l2;
+             b *= 2) {
+                n = add_candidate(candidates, n, b);
+        }
+
+        int side = sqrt((double)TEST_BYTES / size);
+        int best = candidates[0];
+        double bestTime = -1;
+        for (int i = 0; i < n; i++) {
+                if (candidates[i] > side) {
+                        continue;
+                }
+                double time = time_blocksize(candidates[i], size, d4, side);
+                if (bestTime < 0 || time < bestTime) {
+                        bestTime = time;
+                        best = candidates[i];
+                }
+        }
+        return best;
+}
+
+int Blocktune_blocksize(int size, int d4, int *kept)
+{
+        assert(size > 0 && 0 <= d4 && d4 < 8);
+        struct Blocktune_caches caches = Blocktune_caches();
+        int written = 1;
+
+        int blocksize = lookup(&caches, size, d4);
+        if (blocksize <= 1) {
+                blocksize = calibrate(&caches, size, d4);
+                FILE *fp = fopen(Blocktune_file(), "a");
+                written = fp != NULL;
+                if (fp != NULL) {
+                        written = fprintf(fp, "%ld %ld %ld %d %d %d\n",
+                                          caches.l1, caches.l2, caches.llc,
+                                          size, d4, blocksize) > 0;
+                        written = fclose(fp) == 0 && written;
+                }
+        }
+        if (kept != NULL) {
+                *kept = written;
+        }
+        return blocksize;
+}
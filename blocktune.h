@@ -0,0 +1,45 @@
+/*
+ *     blocktune.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for the blocksize auto-tuner. The 64KB block that
+ *     UArray2b_new_64K_block aims for suits some caches and not others, so
+ *     the tuner reads this machine's cache sizes from sysfs, times the
+ *     tile engine over a short sweep of blocksizes sized to those caches,
+ *     and remembers the fastest for each cell size and transform in a
+ *     file that later runs read instead of timing again.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef BLOCKTUNE_INCLUDED
+#define BLOCKTUNE_INCLUDED
+
+/* Sizes in bytes of this machine's caches */
+struct Blocktune_caches {
+        long l1;                /* level 1 data cache */
+        long l2;                /* level 2 cache */
+        long llc;               /* last level cache */
+};
+
+/* returns the cache sizes of CPU 0 as listed in sysfs, with common sizes
+ * standing in for any that cannot be read
+ */
+extern struct Blocktune_caches Blocktune_caches(void);
+
+/* returns the path of the file tuned blocksizes are kept in: $BLOCKTUNE_FILE
+ * if set, else .blocktune in $HOME (or the current directory)
+ */
+extern const char *Blocktune_file(void);
+
+/* returns the fastest blocksize for the tile engine to apply D4 element d4
+ * (see d4.h) to cells of 'size' bytes on this machine: from the tuning
+ * file if it has an entry for these caches, otherwise by timing a sweep of
+ * candidates (a second or two) and adding an entry. If the file cannot be
+ * written the result is not kept, and the next call times the sweep
+ * again. Unless 'kept' is NULL, *kept is set to 0 in that case and to 1
+ * otherwise. The blocksize is at least 2. size < 1 or d4 outside [0, 8) is
+ * a checked run-time error.
+ */
+extern int Blocktune_blocksize(int size, int d4, int *kept);
+
+#endif
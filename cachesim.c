@@ -0,0 +1,198 @@
+/*
+ *     cachesim.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the cache simulator. Every level keeps, for each
+ *     of its sets, the line numbers it holds and when each was last used
+ *     (a count of the level's lookups); a lookup scans its set, and a
+ *     miss replaces the line used longest ago. Levels are neither
+ *     inclusive nor exclusive: a miss fills every level it passed through
+ *     and evicts nothing from the others. The line looked up in a level
+ *     further out is the one holding the first byte of the nearer level's
+ *     line.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "assert.h"
+#include "mem.h"
+#include "cachesim.h"
+
+#define T Cachesim_T
+
+/* Line number of a slot that holds nothing */
+#define EMPTY UINTPTR_MAX
+
+struct Level {
+        struct Cachesim_geometry geometry;
+        long sets;
+        int lineShift;                  /* log2 of the line size */
+        uintptr_t *lines;               /* sets * ways line numbers */
+        unsigned long *lastUse;         /* when each slot was last used */
+        unsigned long clock;
+        struct Cachesim_counts counts;
+};
+
+struct T {
+        int ncaches;
+        int nlevels;                    /* ncaches, plus 1 with a TLB */
+        struct Level *levels;           /* the caches, then the TLB */
+};
+
+/*  init_level
+ *
+ *  Purpose: Sets up an empty level of the given geometry
+ */
+static void init_level(struct Level *level,
+                       const struct Cachesim_geometry *geometry)
+{
+        assert(geometry->ways > 0 && geometry->line > 0);
+        assert((geometry->line & (geometry->line - 1)) == 0);
+        level->geometry = *geometry;
+        level->sets = geometry->size /
+                      ((long)geometry->ways * geometry->line);
+        assert(level->sets > 0);
+        level->lineShift = 0;
+        while ((1 << level->lineShift) < geometry->line) {
+                level->lineShift++;
+        }
+        long slots = level->sets * geometry->ways;
+        level->lines = ALLOC(slots * sizeof(*level->lines));
+        level->lastUse = ALLOC(slots * sizeof(*level->lastUse));
+}
+
+/* Empties a level and zeroes its counts */
+static void clear_level(struct Level *level)
+{
+        long slots = level->sets * level->geometry.ways;
+        for (long s = 0; s < slots; s++) {
+                level->lines[s] = EMPTY;
+                level->lastUse[s] = 0;
+        }
+        level->clock = 0;
+        level->counts.hits = 0;
+        level->counts.misses = 0;
+}
+
+/*  lookup
+ *
+ *  Purpose: Looks up the line holding an address in one level, taking it
+ *           in on a miss in place of the least recently used line of its
+ *           set
+ *
+ *  Returns: 1 on a hit, 0 on a miss
+ */
+static int lookup(struct Level *level, uintptr_t address)
+{
+        uintptr_t line = address >> level->lineShift;
+        int ways = level->geometry.ways;
+        long first = (long)(line % level->sets) * ways;
+        long victim = first;
+        level->clock++;
+        for (long s = first; s < first + ways; s++) {
+                if (level->lines[s] == line) {
+                        level->lastUse[s] = level->clock;
+                        level->counts.hits++;
+                        return 1;
+                }
+                if (level->lastUse[s] < level->lastUse[victim]) {
+                        victim = s;
+                }
+        }
+        level->lines[victim] = line;
+        level->lastUse[victim] = level->clock;
+        level->counts.misses++;
+        return 0;
+}
+
+T Cachesim_new(int ncaches, const struct Cachesim_geometry *caches,
+               const struct Cachesim_geometry *tlb)
+{
+        assert(ncaches > 0 && caches != NULL);
+        T sim;
+        NEW(sim);
+        sim->ncaches = ncaches;
+        sim->nlevels = ncaches + (tlb != NULL);
+        sim->levels = CALLOC(sim->nlevels, sizeof(*sim->levels));
+        for (int l = 0; l < ncaches; l++) {
+                init_level(&sim->levels[l], &caches[l]);
+        }
+        if (tlb != NULL) {
+                init_level(&sim->levels[ncaches], tlb);
+        }
+        Cachesim_reset(sim);
+        return sim;
+}
+
+void Cachesim_free(T *sim)
+{
+        assert(sim != NULL && *sim != NULL);
+        for (int l = 0; l < (*sim)->nlevels; l++) {
+                FREE((*sim)->levels[l].lines);
+                FREE((*sim)->levels[l].lastUse);
+        }
+        FREE((*sim)->levels);
+        FREE(*sim);
+}
+
+void Cachesim_access(T sim, const void *address, int bytes)
+{
+        assert(sim != NULL && bytes > 0);
+        uintptr_t start = (uintptr_t)address;
+        uintptr_t end = start + bytes - 1;
+
+        if (sim->nlevels > sim->ncaches) {
+                struct Level *tlb = &sim->levels[sim->ncaches];
+                for (uintptr_t page = start >> tlb->lineShift;
+                     page <= end >> tlb->lineShift; page++) {
+                        lookup(tlb, page << tlb->lineShift);
+                }
+        }
+
+        /* Each line of the first level, then outwards until one hits */
+        struct Level *near = &sim->levels[0];
+        for (uintptr_t line = start >> near->lineShift;
+             line <= end >> near->lineShift; line++) {
+                uintptr_t lineAddress = line << near->lineShift;
+                for (int l = 0; l < sim->ncaches; l++) {
+                        if (lookup(&sim->levels[l], lineAddress)) {
+                                break;
+                        }
+                }
+        }
+}
+
+void Cachesim_reset(T sim)
+{
+        assert(sim != NULL);
+        for (int l = 0; l < sim->nlevels; l++) {
+                clear_level(&sim->levels[l]);
+        }
+}
+
+int Cachesim_levels(T sim)
+{
+        assert(sim != NULL);
+        return sim->nlevels;
+}
+
+const struct Cachesim_geometry *Cachesim_geometry(T sim, int level)
+{
+        assert(sim != NULL && 0 <= level && level < sim->nlevels);
+        return &sim->levels[level].geometry;
+}
+
+struct Cachesim_counts Cachesim_counts(T sim, int level)
+{
+        assert(sim != NULL && 0 <= level && level < sim->nlevels);
+        return sim->levels[level].counts;
+}
+
+int Cachesim_is_tlb(T sim, int level)
+{
+        assert(sim != NULL && 0 <= level && level < sim->nlevels);
+        return level >= sim->ncaches;
+}
+
+#undef T
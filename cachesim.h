@@ -0,0 +1,73 @@
+/*
+ *     cachesim.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for a cache simulator: a stack of set-associative caches,
+ *     each with its own size, associativity and line size, and a data TLB
+ *     beside them. Each access is looked up in the TLB and then level by
+ *     level until it hits, and the levels it missed in take the line,
+ *     evicting their least recently used one. The simulator counts the
+ *     hits and misses of every level, so the locality of an address
+ *     stream can be judged for caches other than the ones on this machine.
+ *
+ *     Usage:
+ *
+ *       struct Cachesim_geometry l1 = { "L1", 32768, 8, 64, 4 };
+ *       Cachesim_T sim = Cachesim_new(1, &l1, NULL);
+ *       Cachesim_access(sim, address, 12);
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef CACHESIM_INCLUDED
+#define CACHESIM_INCLUDED
+
+#define T Cachesim_T
+typedef struct T *T;
+
+/* A cache level, or a TLB. A TLB's lines are pages: its size is its
+   entries times the page size */
+struct Cachesim_geometry {
+        const char *name;       /* for reports; must outlive the simulator */
+        long size;              /* bytes held */
+        int ways;               /* lines per set */
+        int line;               /* bytes per line, a power of two */
+        int latency;            /* cycles a hit here costs (a miss, for a
+                                   TLB) */
+};
+
+/* Hits and misses of one level */
+struct Cachesim_counts {
+        long hits;
+        long misses;
+};
+
+/* returns a simulator with 'ncaches' cache levels, caches[0] nearest the
+ * CPU, and the TLB 'tlb' (or none if NULL). It starts empty. ncaches < 1,
+ * or a level with fewer than one set or a line that is not a power of two,
+ * is a checked run-time error.
+ */
+extern T Cachesim_new(int ncaches, const struct Cachesim_geometry *caches,
+                      const struct Cachesim_geometry *tlb);
+
+extern void Cachesim_free(T *sim);
+
+/* looks up each line (and page) that the 'bytes' bytes at 'address' touch */
+extern void Cachesim_access(T sim, const void *address, int bytes);
+
+/* empties every level and zeroes the counts */
+extern void Cachesim_reset(T sim);
+
+/* returns the number of levels: the caches, then the TLB if there is one */
+extern int Cachesim_levels(T sim);
+
+/* returns the geometry of a level; the TLB is the last level */
+extern const struct Cachesim_geometry *Cachesim_geometry(T sim, int level);
+
+/* returns the counts of a level since the simulator was made or reset */
+extern struct Cachesim_counts Cachesim_counts(T sim, int level);
+
+/* returns nonzero if 'level' is the TLB */
+extern int Cachesim_is_tlb(T sim, int level);
+
+#undef T
+#endif
@@ -27,6 +27,8 @@
  *****************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
 #include "assert.h"
 #include "cputiming_impl.h"
@@ -41,6 +43,13 @@ static int timespec_subtract (struct timespec *result, struct timespec *x,
 
 static double timespec_to_double(struct timespec *x);
 
+static double elapsed(clockid_t clock, struct timespec *start);
+
+static int compare_doubles(const void *a, const void *b);
+
+static void sorted_stats(double *sorted, int n,
+                         struct CPUTime_Stats *stats);
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
  *              Functions implementing the CPUTime interface
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -61,6 +70,8 @@ void CPUTime_Free(CPUTime_T *startTimepp){
 }
 
 void CPUTime_Start(CPUTime_T startTimep) {
+        clock_gettime(CLOCK_MONOTONIC, &(startTimep->wall));
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &(startTimep->thread));
         clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &(startTimep->time));
         return;
 }
@@ -72,6 +83,81 @@ double CPUTime_Stop(CPUTime_T startTimep) {
         return timespec_to_double(&time_used);
 }
 
+void CPUTime_Sample(CPUTime_T timer, struct CPUTime_Sample *sample) {
+        assert(timer != NULL && sample != NULL);
+        /* Read in the reverse order of CPUTime_Start, so that each clock
+           covers as little of the others' reading as possible */
+        sample->cpu = elapsed(CLOCK_PROCESS_CPUTIME_ID, &(timer->time));
+        sample->thread = elapsed(CLOCK_THREAD_CPUTIME_ID, &(timer->thread));
+        sample->wall = elapsed(CLOCK_MONOTONIC, &(timer->wall));
+}
+
+void CPUTime_Summarize(const double *samples, int n,
+                       struct CPUTime_Stats *stats) {
+        assert(samples != NULL && stats != NULL && n >= 1);
+        double *sorted = malloc(n * sizeof(double));
+        assert(sorted != NULL);
+        memcpy(sorted, samples, n * sizeof(double));
+        qsort(sorted, n, sizeof(double), compare_doubles);
+
+        /* The median absolute deviation, scaled to estimate the standard
+           deviation of normally distributed samples */
+        struct CPUTime_Stats all;
+        sorted_stats(sorted, n, &all);
+        double *deviations = malloc(n * sizeof(double));
+        assert(deviations != NULL);
+        for (int i = 0; i < n; i++) {
+                deviations[i] = fabs(sorted[i] - all.median);
+        }
+        qsort(deviations, n, sizeof(double), compare_doubles);
+        struct CPUTime_Stats spread;
+        sorted_stats(deviations, n, &spread);
+        double limit = CPUTIME_OUTLIER_MADS * 1.4826 * spread.median;
+        free(deviations);
+
+        /* A MAD of 0 means most samples are equal; keep them all then */
+        int lo = 0, hi = n;
+        if (limit > 0) {
+                while (all.median - sorted[lo] > limit) {
+                        lo++;
+                }
+                while (sorted[hi - 1] - all.median > limit) {
+                        hi--;
+                }
+        }
+        sorted_stats(sorted + lo, hi - lo, stats);
+        stats->runs = n;
+        free(sorted);
+}
+
+void CPUTime_Repeat(CPUTime_T timer, int warmup, int reps,
+                    CPUTime_Work *work, void *cl,
+                    struct CPUTime_Repeated *result) {
+        assert(timer != NULL && work != NULL && result != NULL);
+        assert(warmup >= 0 && reps >= 1);
+        for (int i = 0; i < warmup; i++) {
+                work(cl);
+        }
+
+        double *cpu = malloc(3 * reps * sizeof(double));
+        assert(cpu != NULL);
+        double *wall = cpu + reps;
+        double *thread = wall + reps;
+        for (int i = 0; i < reps; i++) {
+                struct CPUTime_Sample sample;
+                CPUTime_Start(timer);
+                work(cl);
+                CPUTime_Sample(timer, &sample);
+                cpu[i] = sample.cpu;
+                wall[i] = sample.wall;
+                thread[i] = sample.thread;
+        }
+        CPUTime_Summarize(cpu, reps, &result->cpu);
+        CPUTime_Summarize(wall, reps, &result->wall);
+        CPUTime_Summarize(thread, reps, &result->thread);
+        free(cpu);
+}
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
  *     Utility functions called internally
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -133,3 +219,57 @@ timespec_to_double(struct timespec *ts) {
                         ts->tv_nsec;
 
 }
+
+/*
+ *  elapsed
+ *
+ *  Nanoseconds on a clock since the time stored in *start
+ */
+static double
+elapsed(clockid_t clock, struct timespec *start) {
+        struct timespec stop, time_used;
+        clock_gettime(clock, &stop);
+        assert(timespec_subtract(&time_used, &stop, start) == 0);
+        return timespec_to_double(&time_used);
+}
+
+/*
+ *  compare_doubles
+ *
+ *  qsort comparison putting doubles in increasing order
+ */
+static int
+compare_doubles(const void *a, const void *b) {
+        double x = *(const double *)a, y = *(const double *)b;
+        return (x > y) - (x < y);
+}
+
+/*
+ *  sorted_stats
+ *
+ *  Summarizes n >= 1 samples already in increasing order, all kept. The
+ *  median of an even count is the mean of the middle two; p95 is the
+ *  smallest sample at or above 95% of them (nearest rank).
+ */
+static void
+sorted_stats(double *sorted, int n, struct CPUTime_Stats *stats) {
+        stats->runs = n;
+        stats->kept = n;
+        stats->min = sorted[0];
+        stats->median = n % 2 == 1 ? sorted[n / 2]
+                                   : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+        int rank = (int)ceil(0.95 * n);
+        stats->p95 = sorted[rank < 1 ? 0 : rank - 1];
+
+        double sum = 0;
+        for (int i = 0; i < n; i++) {
+                sum += sorted[i];
+        }
+        stats->mean = sum / n;
+        double squares = 0;
+        for (int i = 0; i < n; i++) {
+                squares += (sorted[i] - stats->mean) *
+                           (sorted[i] - stats->mean);
+        }
+        stats->stddev = n > 1 ? sqrt(squares / (n - 1)) : 0;
+}
@@ -24,7 +24,16 @@
  *       Note that printf format %.0f is typically a reasonable way to
  *       print such integers.
  *
+ *       Every timer also reads the monotonic wall clock and the
+ *       calling thread's CPU clock, which CPUTime_Sample returns
+ *       together: once work is split among threads, process CPU time
+ *       is the sum of all of them and says little about how long the
+ *       work took. For small, noisy regions, CPUTime_Repeat runs the
+ *       work several times and summarizes each clock.
+ *
  *****************************************************************/
+#ifndef CPUTIMING_INCLUDED
+#define CPUTIMING_INCLUDED
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
  *                   Type definitions
@@ -32,6 +41,31 @@
 
 typedef struct CPU_Time *CPUTime_T;
 
+/* The three clocks over one Start/Stop region, in nanoseconds */
+struct CPUTime_Sample {
+        double cpu;             /* CPU time of every thread of the process */
+        double wall;            /* elapsed time on the monotonic clock */
+        double thread;          /* CPU time of the calling thread alone */
+};
+
+/* Summary of repeated measurements of one clock, in nanoseconds. Samples
+   more than CPUTIME_OUTLIER_MADS scaled median absolute deviations from
+   the median are rejected first; the rest are summarized */
+#define CPUTIME_OUTLIER_MADS 3.0
+struct CPUTime_Stats {
+        int runs;               /* samples given */
+        int kept;               /* samples left after rejecting outliers */
+        double min, median, p95, mean, stddev;
+};
+
+/* Summaries of each clock over CPUTime_Repeat's runs */
+struct CPUTime_Repeated {
+        struct CPUTime_Stats cpu, wall, thread;
+};
+
+/* Work timed by CPUTime_Repeat */
+typedef void CPUTime_Work(void *cl);
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
  *              Functions implementing the CPUTime interface
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -45,3 +79,19 @@ void CPUTime_Free(CPUTime_T *startTimepp);
 void CPUTime_Start(CPUTime_T StartTimep) ;
 
 double CPUTime_Stop(CPUTime_T startTimep) ;
+
+/* stops the timer like CPUTime_Stop, filling in all three clocks */
+void CPUTime_Sample(CPUTime_T timer, struct CPUTime_Sample *sample);
+
+/* summarizes n >= 1 samples (which are left unchanged) into *stats */
+void CPUTime_Summarize(const double *samples, int n,
+                       struct CPUTime_Stats *stats);
+
+/* calls work(cl) warmup times untimed, then reps >= 1 times timed with
+ * timer, and summarizes each clock over the timed runs
+ */
+void CPUTime_Repeat(CPUTime_T timer, int warmup, int reps,
+                    CPUTime_Work *work, void *cl,
+                    struct CPUTime_Repeated *result);
+
+#endif
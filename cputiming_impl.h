@@ -32,5 +32,7 @@
 #include "cputiming.h"
 
 struct CPU_Time {
-        struct timespec time;
+        struct timespec time;           /* process CPU clock */
+        struct timespec wall;           /* monotonic clock */
+        struct timespec thread;         /* calling thread's CPU clock */
 };
@@ -0,0 +1,180 @@
+/*
+ *     d4.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the D4 interface: composition of grid symmetries
+ *     and the coordinate transformation for each of them.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include "assert.h"
+#include "d4.h"
+
+/*  D4_compose
+      Purpose: Composes two symmetries. Writing each as flips after an
+               optional swap, a swap in 'then' moves across the flips of
+               'first' by exchanging which axis each of them mirrors.
+   Parameters: The element applied first, the element applied second
+      Returns: The single equivalent element
+*/
+int D4_compose(int first, int then)
+{
+        assert(first >= 0 && first < 8 && then >= 0 && then < 8);
+        int flipCol = first & D4_FLIP_COL;
+        int flipRow = first & D4_FLIP_ROW;
+        if (then & D4_SWAP) {
+                int swapped = (flipCol ? D4_FLIP_ROW : 0) |
+                              (flipRow ? D4_FLIP_COL : 0);
+                flipCol = swapped & D4_FLIP_COL;
+                flipRow = swapped & D4_FLIP_ROW;
+        }
+        return ((first ^ then) & D4_SWAP) |
+               ((flipCol | flipRow) ^ (then & (D4_FLIP_COL | D4_FLIP_ROW)));
+}
+
+/*  D4_swaps_dimensions
+      Purpose: Tells whether the output's width is the input's height
+   Parameters: A D4 element
+      Returns: Nonzero for transpose, transverse and rotations by 90 and 270
+*/
+int D4_swaps_dimensions(int d4)
+{
+        assert(d4 >= 0 && d4 < 8);
+        return d4 & D4_SWAP;
+}
+
+/*  D4_transformation
+      Purpose: Looks up the coordinate transformation for an element
+   Parameters: A D4 element
+      Returns: Pointer to the transformation function
+*/
+transformation *D4_transformation(int d4)
+{
+        static transformation *const functions[8] = {
+                transform_0, horizontal, vertical, transform_180,
+                transpose, transform_90, transform_270, transverse
+        };
+        assert(d4 >= 0 && d4 < 8);
+        return functions[d4];
+}
+
+/*  D4_id
+      Purpose: Gives the identifier used for an element in timing reports
+   Parameters: A D4 element
+      Returns: A constant string
+*/
+const char *D4_id(int d4)
+{
+        static const char *const ids[8] = {
+                "rotate-0", "flip-horizontal", "flip-vertical", "rotate-180",
+                "transpose", "rotate-90", "rotate-270", "transverse"
+        };
+        assert(d4 >= 0 && d4 < 8);
+        return ids[d4];
+}
+
+/* transform_0
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void transform_0(int *col, int *row, int width, int height)
+{
+        (void) col;
+        (void) row;
+        (void) width;
+        (void) height;
+}
+
+/* transform_90
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void transform_90(int *col, int *row, int width, int height)
+{
+        (void) width;
+        int newRow = *col;
+        *col = height - *row - 1;
+        *row = newRow;
+}
+
+/* transform_180
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void transform_180(int *col, int *row, int width, int height)
+{
+       *col = width - *col - 1;
+        *row = height - *row - 1;
+}
+
+/* transform_270
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void transform_270(int *col, int *row, int width, int height)
+{
+        (void) height;
+        int newRow = width - *col - 1;
+        *col = *row;
+        *row = newRow;
+}
+
+/* horizontal
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void horizontal(int *col, int *row, int width, int height){
+        (void) height;
+        (void) row;
+        *col = width - *col - 1;
+}
+
+/* vertical
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void vertical(int *col, int *row, int width, int height){
+        (void) width;
+        int newRow = height - *row - 1;
+        *col = *col;
+        *row = newRow;
+}
+
+/* transpose
+      Purpose: Performs transformation math on the row/col cordinates
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void transpose(int *col, int *row, int width, int height) {
+        (void) height;
+        (void) width;
+        int newRow = *col;
+        *col = *row;
+        *row = newRow;
+}
+
+/* transverse
+      Purpose: Performs transformation math on the row/col cordinates
+               (reflection across the UR-to-LL axis)
+   Parameters: Column value pointer, Row value pointer, width of the array,
+               height of the array
+      Returns: None
+*/
+void transverse(int *col, int *row, int width, int height) {
+        int newRow = width - *col - 1;
+        *col = height - *row - 1;
+        *row = newRow;
+}
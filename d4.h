@@ -0,0 +1,63 @@
+/*
+ *     d4.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for the eight symmetries of a rectangular grid (the
+ *     dihedral group D4): the four rotations, the two flips, transpose and
+ *     transverse. Each is encoded in three bits - first optionally swap
+ *     rows and columns (transpose), then optionally mirror the columns,
+ *     then optionally mirror the rows - so any sequence of transforms
+ *     composes into exactly one of the eight and can be applied in a single
+ *     pass.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef D4_INCLUDED
+#define D4_INCLUDED
+
+/* Used for declaring pointers to the relevant transformational functions.
+   Maps a source (col, row) to its destination, given the source width and
+   height */
+typedef void transformation(int *col, int *row, int width, int height);
+
+/* Bits of a D4 element */
+#define D4_SWAP      4          /* transpose first */
+#define D4_FLIP_ROW  2          /* then mirror top-bottom */
+#define D4_FLIP_COL  1          /* then mirror left-right */
+
+/* The eight elements */
+#define D4_ROTATE_0        0
+#define D4_FLIP_HORIZONTAL D4_FLIP_COL
+#define D4_FLIP_VERTICAL   D4_FLIP_ROW
+#define D4_ROTATE_180      (D4_FLIP_COL | D4_FLIP_ROW)
+#define D4_TRANSPOSE       D4_SWAP
+#define D4_ROTATE_90       (D4_SWAP | D4_FLIP_COL)
+#define D4_ROTATE_270      (D4_SWAP | D4_FLIP_ROW)
+#define D4_TRANSVERSE      (D4_SWAP | D4_FLIP_COL | D4_FLIP_ROW)
+
+/* returns the element equivalent to applying 'first' and then 'then' */
+extern int D4_compose(int first, int then);
+
+/* returns nonzero if the element exchanges width and height */
+extern int D4_swaps_dimensions(int d4);
+
+/* returns the coordinate transformation for the element */
+extern transformation *D4_transformation(int d4);
+
+/* returns a stable identifier for the element for machine-readable
+ * reports: rotate-0, flip-horizontal, flip-vertical, rotate-180,
+ * transpose, rotate-90, rotate-270 or transverse
+ */
+extern const char *D4_id(int d4);
+
+/* the coordinate transformations themselves */
+extern void transform_0(int *col, int *row, int width, int height);
+extern void transform_90(int *col, int *row, int width, int height);
+extern void transform_180(int *col, int *row, int width, int height);
+extern void transform_270(int *col, int *row, int width, int height);
+extern void transpose(int *col, int *row, int width, int height);
+extern void transverse(int *col, int *row, int width, int height);
+extern void horizontal(int *col, int *row, int width, int height);
+extern void vertical(int *col, int *row, int width, int height);
+
+#endif
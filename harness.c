@@ -0,0 +1,163 @@
+/*
+ *     harness.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the options, layouts, synthetic images and
+ *     per-pixel copy that bench and locality share.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "assert.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "a2morton.h"
+#include "harness.h"
+
+const struct Harness_layout Harness_layouts[HARNESS_LAYOUTS] = {
+        { "plain",   &uarray2_methods_plain },
+        { "blocked", &uarray2_methods_blocked },
+        { "morton",  &uarray2_methods_morton },
+};
+
+/* parse_list
+      Purpose: Parses a comma-separated list of non-negative integers
+   Parameters: The list, where to store the numbers
+      Returns: How many numbers there were, or 0 if one did not parse or
+               there were more than HARNESS_MAX_LIST
+*/
+static int parse_list(char *list, int *out)
+{
+        int n = 0;
+        for (char *item = strtok(list, ","); item != NULL;
+             item = strtok(NULL, ",")) {
+                char *end;
+                long value = strtol(item, &end, 10);
+                if (*end != '\0' || value < 0 || n == HARNESS_MAX_LIST) {
+                        return 0;
+                }
+                out[n++] = value;
+        }
+        return n;
+}
+
+/* parse_sizes
+      Purpose: Parses a comma-separated list of WxH image shapes into the
+               cases, leaving none if one does not parse or there are more
+               than HARNESS_MAX_LIST
+   Parameters: The list, the cases
+      Returns: None
+*/
+static void parse_sizes(char *list, struct Harness_cases *cases)
+{
+        cases->shapes = 0;
+        for (char *item = strtok(list, ","); item != NULL;
+             item = strtok(NULL, ",")) {
+                int w, h;
+                char extra;
+                if (sscanf(item, "%dx%d%c", &w, &h, &extra) != 2 || w < 1 ||
+                    h < 1 || cases->shapes == HARNESS_MAX_LIST) {
+                        cases->shapes = 0;
+                        return;
+                }
+                cases->widths[cases->shapes] = w;
+                cases->heights[cases->shapes] = h;
+                cases->shapes++;
+        }
+}
+
+void Harness_defaults(struct Harness_cases *cases)
+{
+        assert(cases != NULL);
+        cases->shapes = 0;
+        cases->cells[0] = 12;           /* struct Pnm_rgb */
+        cases->ncells = 1;
+        cases->nd4s = 8;
+        for (int d = 0; d < 8; d++) {
+                cases->d4s[d] = d;
+        }
+        cases->layout = NULL;
+}
+
+int Harness_option(struct Harness_cases *cases, int argc, char *argv[],
+                   int *i)
+{
+        assert(cases != NULL && argv != NULL && i != NULL && *i < argc);
+        const char *option = argv[*i];
+        if (*i + 1 >= argc) {
+                return 0;
+        }
+        char *value = argv[*i + 1];
+        if (strcmp(option, "-sizes") == 0) {
+                parse_sizes(value, cases);
+        } else if (strcmp(option, "-cells") == 0) {
+                cases->ncells = parse_list(value, cases->cells);
+        } else if (strcmp(option, "-transforms") == 0) {
+                cases->nd4s = parse_list(value, cases->d4s);
+        } else if (strcmp(option, "-layout") == 0) {
+                cases->layout = value;
+        } else {
+                return 0;
+        }
+        *i += 1;
+        return 1;
+}
+
+int Harness_valid(const struct Harness_cases *cases)
+{
+        assert(cases != NULL);
+        if (cases->shapes == 0 || cases->ncells == 0 || cases->nd4s == 0) {
+                return 0;
+        }
+        int known = 0;
+        for (int l = 0; l < HARNESS_LAYOUTS; l++) {
+                known = known || Harness_wants(cases, l);
+        }
+        if (!known) {
+                return 0;
+        }
+        for (int d = 0; d < cases->nd4s; d++) {
+                if (cases->d4s[d] > 7) {
+                        return 0;
+                }
+        }
+        for (int k = 0; k < cases->ncells; k++) {
+                if (cases->cells[k] < 1) {
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+int Harness_wants(const struct Harness_cases *cases, int l)
+{
+        assert(cases != NULL && 0 <= l && l < HARNESS_LAYOUTS);
+        return cases->layout == NULL ||
+               strcmp(cases->layout, Harness_layouts[l].name) == 0;
+}
+
+void Harness_fill(A2Methods_T methods, A2Methods_UArray2 image)
+{
+        assert(methods != NULL && image != NULL);
+        int size = methods->size(image);
+        for (int row = 0; row < methods->height(image); row++) {
+                for (int col = 0; col < methods->width(image); col++) {
+                        unsigned char *cell = methods->at(image, col, row);
+                        for (int b = 0; b < size; b++) {
+                                cell[b] = col * 7 + row * 13 + b;
+                        }
+                }
+        }
+}
+
+void Harness_copy_cell(int col, int row, A2Methods_UArray2 array2,
+                       A2Methods_Object *elem, void *cl)
+{
+        struct Harness_copy *copy = cl;
+        copy->transform(&col, &row, copy->methods->width(array2),
+                        copy->methods->height(array2));
+        memcpy(copy->methods->at(copy->dest, col, row), elem,
+               copy->methods->size(array2));
+}
@@ -0,0 +1,95 @@
+/*
+ *     harness.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for what bench and locality share: the options choosing
+ *     which image shapes, cell sizes, transforms and layouts to run, the
+ *     layouts themselves, and the synthetic images and per-pixel copy that
+ *     each case moves.
+ *
+ *     Usage:
+ *
+ *       struct Harness_cases cases;
+ *       Harness_defaults(&cases);
+ *       ... Harness_option(&cases, argc, argv, &i) for each argument ...
+ *       if (!Harness_valid(&cases)) usage(argv[0]);
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef HARNESS_INCLUDED
+#define HARNESS_INCLUDED
+#include "a2methods.h"
+#include "d4.h"
+
+/* Most image shapes, cell sizes or transforms on one command line */
+#define HARNESS_MAX_LIST 32
+
+/* The options Harness_option takes, and what the numbers given to
+   -transforms mean, for usage messages */
+#define HARNESS_USAGE                                                   \
+        "[-sizes WxH,...] [-cells N,...] [-transforms D4,...] "         \
+        "[-layout {plain,blocked,morton}]"
+#define HARNESS_D4_USAGE                                                \
+        "  D4 elements: 0 rotate-0, 1 flip-horizontal, 2 flip-vertical, " \
+        "3 rotate-180,\n"                                               \
+        "               4 transpose, 5 rotate-90, 6 rotate-270, "       \
+        "7 transverse\n"
+
+/* The layouts, by the name -layout takes */
+#define HARNESS_LAYOUTS 3
+struct Harness_layout {
+        const char *name;
+        A2Methods_T *methods;
+};
+extern const struct Harness_layout Harness_layouts[HARNESS_LAYOUTS];
+
+/* Which cases to run */
+struct Harness_cases {
+        int widths[HARNESS_MAX_LIST], heights[HARNESS_MAX_LIST], shapes;
+        int cells[HARNESS_MAX_LIST], ncells;
+        int d4s[HARNESS_MAX_LIST], nd4s;
+        const char *layout;     /* NULL for all */
+};
+
+/* What Harness_copy_cell needs: the methods, the array each cell goes to
+   and where it goes */
+struct Harness_copy {
+        A2Methods_T methods;
+        A2Methods_UArray2 dest;
+        transformation *transform;
+};
+
+/* sets up 12-byte cells (struct Pnm_rgb), every transform and every
+ * layout, and no shapes
+ */
+extern void Harness_defaults(struct Harness_cases *cases);
+
+/* if argv[*i] is -sizes, -cells, -transforms or -layout, takes it and the
+ * value after it into 'cases', advances *i past them and returns nonzero;
+ * otherwise returns 0. A value that does not parse, or a list longer than
+ * HARNESS_MAX_LIST, leaves its list empty, so Harness_valid rejects it
+ */
+extern int Harness_option(struct Harness_cases *cases, int argc,
+                          char *argv[], int *i);
+
+/* returns nonzero if there is at least one shape, cell size and transform,
+ * every cell size is positive, every transform is a D4 element and the
+ * layout is known
+ */
+extern int Harness_valid(const struct Harness_cases *cases);
+
+/* returns nonzero if Harness_layouts[l] is one of the layouts to run */
+extern int Harness_wants(const struct Harness_cases *cases, int l);
+
+/* gives every byte of an image a position-dependent value, so that its
+ * pages exist before anything is measured
+ */
+extern void Harness_fill(A2Methods_T methods, A2Methods_UArray2 image);
+
+/* apply function for the maps: copies one cell to its transformed position
+ * in the destination; the closure is a struct Harness_copy
+ */
+extern void Harness_copy_cell(int col, int row, A2Methods_UArray2 array2,
+                              A2Methods_Object *elem, void *cl);
+
+#endif
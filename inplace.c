@@ -0,0 +1,310 @@
+/*
+ *     inplace.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of in-place transforms. A flip or a 180 degree
+ *     rotation pairs each row with its mirror row (or with itself when the
+ *     rows stay put) and exchanges the cells of the two rows, reversing
+ *     their order when the columns are mirrored as well. Rows whose cells
+ *     are contiguous in the layout are swapped through pointers; others go
+ *     through methods->at one cell at a time.
+ *
+ *     Transforms that swap width and height permute the cells in cycles.
+ *     On a square array every cycle has at most four cells (a rotation
+ *     moves four corners of a ring at once); the cells are visited tile by
+ *     tile and the cell with the smallest row-major index on each cycle
+ *     moves the whole cycle. On a rectangular plain array the cycles are
+ *     long and irregular, so they are followed through the flat row-major
+ *     storage with one bit per cell marking the cells already placed, and
+ *     the array is then given its new shape.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <string.h>
+#include <mem.h>
+#include "assert.h"
+#include "inplace.h"
+#include "a2plain.h"
+#include "uarray2.h"
+#include "workers.h"
+
+/* Bytes exchanged per step when swapping whole rows */
+#define SWAP_CHUNK 512
+
+/* Cells along one side of the tiles a square array is visited in */
+#define INPLACE_TILE 32
+
+/* State shared by every task of one Inplace_apply call */
+struct Job {
+        A2Methods_T methods;
+        A2Methods_UArray2 array2;
+        int width, height, size;
+        int flipCol, flipRow;
+        transformation *transform;
+        int pairs;              /* row pairs to exchange */
+        int ntasks;
+};
+
+/* Exchanges n bytes at a and b */
+static inline void swap_bytes(char *a, char *b, size_t n)
+{
+        char tmp[SWAP_CHUNK];
+        while (n > 0) {
+                size_t step = n < SWAP_CHUNK ? n : SWAP_CHUNK;
+                memcpy(tmp, a, step);
+                memcpy(a, b, step);
+                memcpy(b, tmp, step);
+                a += step;
+                b += step;
+                n -= step;
+        }
+}
+
+/* Returns the first cell of row if the whole row is contiguous in the
+   layout, else NULL */
+static char *contiguous_row(struct Job *j, int row)
+{
+        char *first = j->methods->at(j->array2, 0, row);
+        char *last = j->methods->at(j->array2, j->width - 1, row);
+        return last - first == (long)(j->width - 1) * j->size ? first : NULL;
+}
+
+/*  swap_rows
+ *
+ *  Purpose: Exchanges row 'top' with row 'bottom', reversing the order of
+ *           the cells if the columns are mirrored. If the two are the same
+ *           row, only its halves are exchanged.
+ *
+ *  Parameters: job state, the two rows
+ *
+ *  Returns: None
+ */
+static void swap_rows(struct Job *j, int top, int bottom)
+{
+        int w = j->width;
+        int size = j->size;
+        int ncols = top == bottom ? w / 2 : w;
+        char *a = contiguous_row(j, top);
+        char *b = contiguous_row(j, bottom);
+
+        if (a != NULL && b != NULL) {
+                if (!j->flipCol) {
+                        swap_bytes(a, b, (size_t)w * size);
+                        return;
+                }
+                char *end = b + (long)(w - 1) * size;
+                for (int col = 0; col < ncols; col++) {
+                        swap_bytes(a, end, size);
+                        a += size;
+                        end -= size;
+                }
+                return;
+        }
+        for (int col = 0; col < ncols; col++) {
+                int other = j->flipCol ? w - col - 1 : col;
+                swap_bytes(j->methods->at(j->array2, col, top),
+                           j->methods->at(j->array2, other, bottom), size);
+        }
+}
+
+/*  pair_task
+ *
+ *  Purpose: Scheduler task; exchanges band number 'task' of the row pairs
+ *
+ *  Parameters: band number, thread running it, job state
+ *
+ *  Returns: None
+ */
+static void pair_task(int task, int thread, void *cl)
+{
+        struct Job *j = cl;
+        int lo, hi;
+        (void)thread;
+        Workers_split(j->pairs, j->ntasks, task, &lo, &hi);
+        for (int row = lo; row < hi; row++) {
+                swap_rows(j, row, j->flipRow ? j->height - row - 1 : row);
+        }
+}
+
+/* Returns nonzero if (col, row) has the smallest row-major index on its
+   cycle, so that each cycle is moved by exactly one of its cells */
+static inline int leads_cycle(struct Job *j, int col, int row)
+{
+        int n = j->width;
+        long index = (long)row * n + col;
+        int c = col, r = row;
+        for (;;) {
+                j->transform(&c, &r, n, n);
+                if (c == col && r == row) {
+                        return 1;
+                }
+                if ((long)r * n + c < index) {
+                        return 0;
+                }
+        }
+}
+
+/*  rotate_cycle
+ *
+ *  Purpose: Moves every cell on the cycle through (col, row) to its
+ *           transformed position. Swapping the first cell with each of the
+ *           others in turn passes each value one step along the cycle.
+ *
+ *  Parameters: job state, a cell of the cycle
+ *
+ *  Returns: None
+ */
+static void rotate_cycle(struct Job *j, int col, int row)
+{
+        int n = j->width;
+        char *first = j->methods->at(j->array2, col, row);
+        int c = col, r = row;
+        j->transform(&c, &r, n, n);
+        while (c != col || r != row) {
+                swap_bytes(first, j->methods->at(j->array2, c, r), j->size);
+                j->transform(&c, &r, n, n);
+        }
+}
+
+/*  square_task
+ *
+ *  Purpose: Scheduler task; moves the cycles led by cells in band number
+ *           'task' of the rows of tiles of a square array. Cycles are
+ *           disjoint, so bands can run concurrently.
+ *
+ *  Parameters: band number, thread running it, job state
+ *
+ *  Returns: None
+ */
+static void square_task(int task, int thread, void *cl)
+{
+        struct Job *j = cl;
+        int n = j->width;
+        int tiles = (n + INPLACE_TILE - 1) / INPLACE_TILE;
+        int lo, hi;
+        (void)thread;
+        Workers_split(tiles, j->ntasks, task, &lo, &hi);
+        for (int row0 = lo * INPLACE_TILE; row0 < hi * INPLACE_TILE &&
+                                           row0 < n; row0 += INPLACE_TILE) {
+                int row1 = row0 + INPLACE_TILE < n ? row0 + INPLACE_TILE : n;
+                for (int col0 = 0; col0 < n; col0 += INPLACE_TILE) {
+                        int col1 = col0 + INPLACE_TILE < n ? col0 + INPLACE_TILE
+                                                           : n;
+                        for (int row = row0; row < row1; row++) {
+                                for (int col = col0; col < col1; col++) {
+                                        if (leads_cycle(j, col, row)) {
+                                                rotate_cycle(j, col, row);
+                                        }
+                                }
+                        }
+                }
+        }
+}
+
+/* Returns the row-major index, in the transformed shape, that the cell at
+   row-major index k of a plain array moves to */
+static inline long destination(struct Job *j, long k)
+{
+        int col = (int)(k % j->width);
+        int row = (int)(k / j->width);
+        j->transform(&col, &row, j->width, j->height);
+        return (long)row * j->height + col;
+}
+
+/*  follow_cycles
+ *
+ *  Purpose: Transforms a rectangular plain array whose width and height
+ *           are exchanged, following each cycle of the permutation through
+ *           the row-major storage, then reshapes the array
+ *
+ *  Parameters: job state
+ *
+ *  Returns: None
+ */
+static void follow_cycles(struct Job *j)
+{
+        long n = (long)j->width * j->height;
+        long size = j->size;
+        char *base = j->methods->at(j->array2, 0, 0);
+        unsigned char *placed = CALLOC((n + 7) / 8, 1);
+
+        for (long k = 0; k < n; k++) {
+                if (placed[k >> 3] & (1 << (k & 7))) {
+                        continue;
+                }
+                placed[k >> 3] |= 1 << (k & 7);
+                for (long next = destination(j, k); next != k;
+                     next = destination(j, next)) {
+                        swap_bytes(base + k * size, base + next * size, size);
+                        placed[next >> 3] |= 1 << (next & 7);
+                }
+        }
+        FREE(placed);
+        UArray2_reshape(j->array2, j->height, j->width);
+}
+
+int Inplace_supports(A2Methods_T methods, A2Methods_UArray2 array2, int d4)
+{
+        assert(methods != NULL && array2 != NULL);
+        assert(d4 >= 0 && d4 < 8);
+        return !D4_swaps_dimensions(d4) ||
+               methods->width(array2) == methods->height(array2) ||
+               methods == uarray2_methods_plain;
+}
+
+void Inplace_apply(A2Methods_T methods, A2Methods_UArray2 array2, int d4,
+                   Sched_T sched)
+{
+        assert(Inplace_supports(methods, array2, d4));
+
+        struct Job j;
+        j.methods = methods;
+        j.array2 = array2;
+        j.width = methods->width(array2);
+        j.height = methods->height(array2);
+        j.size = methods->size(array2);
+        j.flipCol = (d4 & D4_FLIP_COL) != 0;
+        j.flipRow = (d4 & D4_FLIP_ROW) != 0;
+        j.transform = D4_transformation(d4);
+
+        if (D4_swaps_dimensions(d4)) {
+                if (j.width != j.height) {
+                        follow_cycles(&j);
+                } else if (sched == NULL) {
+                        j.ntasks = 1;
+                        square_task(0, 0, &j);
+                } else {
+                        int tiles = (j.width + INPLACE_TILE - 1) / INPLACE_TILE;
+                        j.ntasks = Sched_threads(sched) *
+                                   SCHED_TASKS_PER_THREAD;
+                        if (j.ntasks > tiles) {
+                                j.ntasks = tiles;
+                        }
+                        Sched_run(sched, j.ntasks, square_task, &j);
+                }
+                return;
+        }
+        if (!j.flipCol && !j.flipRow) {
+                return;
+        }
+
+        /* The middle row of an odd height pairs with itself */
+        j.pairs = j.flipRow ? (j.height + 1) / 2 : j.height;
+        if (j.flipRow && !j.flipCol && j.height % 2 == 1) {
+                j.pairs--;
+        }
+        if (j.pairs == 0) {
+                return;
+        }
+
+        if (sched == NULL) {
+                j.ntasks = 1;
+                pair_task(0, 0, &j);
+        } else {
+                j.ntasks = Sched_threads(sched) * SCHED_TASKS_PER_THREAD;
+                if (j.ntasks > j.pairs) {
+                        j.ntasks = j.pairs;
+                }
+                Sched_run(sched, j.ntasks, pair_task, &j);
+        }
+}
@@ -0,0 +1,57 @@
+/*
+ *     inplace.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for transforming an image inside the array that holds it.
+ *     Rotating by 180 degrees and flipping only exchange pairs of cells, so
+ *     they need no second array: the transformed image can be written
+ *     straight from the array it was read into, halving peak memory.
+ *     Transforms that swap width and height are done in place for square
+ *     arrays of any layout and for arrays from uarray2_methods_plain.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef INPLACE_INCLUDED
+#define INPLACE_INCLUDED
+
+#include "a2methods.h"
+#include "d4.h"
+#include "sched.h"
+
+/*  Inplace_supports
+ *
+ *  Purpose: Tells whether Inplace_apply can perform a transform
+ *
+ *  Parameters: methods and array to transform, D4 element of the transform
+ *
+ *  Returns: Nonzero if the element keeps the array's dimensions, the
+ *           array is square, or the array is plain (its cells stored
+ *           row by row in one UArray2)
+ */
+extern int Inplace_supports(A2Methods_T methods, A2Methods_UArray2 array2,
+                            int d4);
+
+/*  Inplace_apply
+ *
+ *  Purpose: Moves every cell of array2 to its transformed position by
+ *           swapping cells; a plain array that is not square has its width
+ *           and height exchanged for the transforms that swap them
+ *
+ *  Parameters:
+ *
+ *    methods: methods for the array
+ *    array2:  array holding the image, transformed in place
+ *    d4:      D4 element of the transform
+ *    sched:   scheduler whose threads share out the rows, or NULL to do
+ *             every row on the calling thread. Rectangular arrays are
+ *             always done on the calling thread.
+ *
+ *  Returns: None
+ *
+ *  Errors: checked runtime error if Inplace_supports is false for the
+ *          arguments
+ */
+extern void Inplace_apply(A2Methods_T methods, A2Methods_UArray2 array2,
+                          int d4, Sched_T sched);
+
+#endif
@@ -0,0 +1,435 @@
+/*
+ *     locality.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Locality analyzer. For every image shape asked for, it moves a
+ *     synthetic image through each transform with each map of each
+ *     A2Methods layout, one apply call per pixel as bench's map traversals
+ *     make, and feeds the address of every cell that at() returns and
+ *     every map visits to a cache simulator (see cachesim.h and a2sim.h)
+ *     with the cache and TLB geometry given on the command line. Each case
+ *     starts with the caches empty and is reported as one CSV row or JSON
+ *     object with the hits and misses of every level, an estimate of the
+ *     cycles per pixel those cost, and the case's rank by that estimate
+ *     among the cases of the same transform: Figure 1 of the analysis
+ *     below, for caches we may not have.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mem.h>
+#include "assert.h"
+#include "a2methods.h"
+#include "a2sim.h"
+#include "cachesim.h"
+#include "d4.h"
+#include "blocktune.h"
+#include "harness.h"
+
+/* Most cache levels on one command line */
+#define MAX_LEVELS 32
+
+/* The maps, in the order of A2Methods_T */
+#define MAPS 4
+static const char *mapNames[MAPS] = {
+        "row-major", "col-major", "block-major", "default"
+};
+
+/* Cycles a hit in cache level N costs unless the command line says, and
+   what a TLB miss and a trip to memory cost */
+static const int defaultLatencies[] = { 4, 14, 50 };
+#define DEFAULT_TLB_LATENCY 20
+#define DEFAULT_MEMORY_LATENCY 200
+
+/* What to run, from the command line */
+struct Options {
+        struct Harness_cases cases;
+        struct Cachesim_geometry caches[MAX_LEVELS];
+        int ncaches;
+        struct Cachesim_geometry tlb;
+        int hasTlb;
+        int line;
+        int memoryLatency;
+        int json;
+};
+
+/* What a case reports */
+struct Result {
+        const char *layout, *traversal;
+        int d4;
+        struct Cachesim_counts counts[MAX_LEVELS + 1];
+        double cycles;          /* estimated, per pixel */
+        int rank;
+};
+
+/* usage
+      Purpose: Prints how to run the analyzer and exits with status 1
+   Parameters: Name the program was run as
+      Returns: None
+*/
+static void usage(const char *progname)
+{
+        fprintf(stderr,
+                "Usage: %s " HARNESS_USAGE " "
+                "[-caches NAME:SIZE:WAYS[:CYCLES],...] [-line BYTES] "
+                "[-tlb {ENTRIES:WAYS:PAGE[:CYCLES],none}] "
+                "[-memory CYCLES] [-json]\n"
+                "  sizes take a K or M suffix; "
+                "the default caches are this machine's,\n"
+                "  as L1:SIZE:8:4,L2:SIZE:16:14,L3:SIZE:16:50, "
+                "with 64-byte lines and -tlb 64:4:4K:20\n"
+                HARNESS_D4_USAGE,
+                progname);
+        exit(1);
+}
+
+/* parse_number
+      Purpose: Parses one positive number, in bytes if it has a K or M
+               suffix
+   Parameters: The text (NULL if it is missing), name of the program
+      Returns: The number
+*/
+static long parse_number(const char *text, const char *progname)
+{
+        if (text == NULL) {
+                usage(progname);
+        }
+        char *unit;
+        long value = strtol(text, &unit, 10);
+        if (*unit == 'K') {
+                value *= 1024;
+                unit++;
+        } else if (*unit == 'M') {
+                value *= 1024 * 1024;
+                unit++;
+        }
+        if (*unit != '\0' || value < 1) {
+                usage(progname);
+        }
+        return value;
+}
+
+/* parse_caches
+      Purpose: Parses a comma-separated list of NAME:SIZE:WAYS[:CYCLES]
+               cache levels, nearest the CPU first, into the options
+   Parameters: The list, options, name of the program
+      Returns: None
+*/
+static void parse_caches(char *list, struct Options *opts,
+                         const char *progname)
+{
+        char *levels, *fields;
+        opts->ncaches = 0;
+        for (char *item = strtok_r(list, ",", &levels); item != NULL;
+             item = strtok_r(NULL, ",", &levels)) {
+                if (opts->ncaches == MAX_LEVELS) {
+                        usage(progname);
+                }
+                struct Cachesim_geometry *g = &opts->caches[opts->ncaches];
+                g->name = strtok_r(item, ":", &fields);
+                g->size = parse_number(strtok_r(NULL, ":", &fields),
+                                       progname);
+                g->ways = parse_number(strtok_r(NULL, ":", &fields),
+                                       progname);
+                char *latency = strtok_r(NULL, ":", &fields);
+                g->latency = latency != NULL ? parse_number(latency, progname)
+                             : defaultLatencies[opts->ncaches < 2 ?
+                                                opts->ncaches : 2];
+                if (strtok_r(NULL, ":", &fields) != NULL) {
+                        usage(progname);
+                }
+                opts->ncaches++;
+        }
+}
+
+/* parse_tlb
+      Purpose: Parses an ENTRIES:WAYS:PAGE[:CYCLES] TLB, or "none", into the
+               options
+   Parameters: The TLB, options, name of the program
+      Returns: None
+*/
+static void parse_tlb(char *text, struct Options *opts, const char *progname)
+{
+        opts->hasTlb = strcmp(text, "none") != 0;
+        if (!opts->hasTlb) {
+                return;
+        }
+        char *fields;
+        long entries = parse_number(strtok_r(text, ":", &fields), progname);
+        opts->tlb.ways = parse_number(strtok_r(NULL, ":", &fields),
+                                      progname);
+        opts->tlb.line = parse_number(strtok_r(NULL, ":", &fields),
+                                      progname);
+        opts->tlb.size = entries * opts->tlb.line;
+        char *latency = strtok_r(NULL, ":", &fields);
+        opts->tlb.latency = latency != NULL ? parse_number(latency, progname)
+                                            : DEFAULT_TLB_LATENCY;
+        if (strtok_r(NULL, ":", &fields) != NULL) {
+                usage(progname);
+        }
+}
+
+/* default_caches
+      Purpose: Fills in this machine's cache sizes with common
+               associativities and latencies, and a common data TLB
+   Parameters: Options to fill in
+      Returns: None
+*/
+static void default_caches(struct Options *opts)
+{
+        struct Blocktune_caches sizes = Blocktune_caches();
+        struct Cachesim_geometry caches[] = {
+                { "L1", sizes.l1,  8,  64, defaultLatencies[0] },
+                { "L2", sizes.l2,  16, 64, defaultLatencies[1] },
+                { "L3", sizes.llc, 16, 64, defaultLatencies[2] },
+        };
+        opts->ncaches = sizes.llc > sizes.l2 ? 3 : 2;
+        memcpy(opts->caches, caches, sizeof(caches));
+        struct Cachesim_geometry tlb = {
+                "TLB", 64 * 4096, 4, 4096, DEFAULT_TLB_LATENCY
+        };
+        opts->tlb = tlb;
+        opts->hasTlb = 1;
+}
+
+/* valid_geometry
+      Purpose: Says whether the simulator can model a level
+   Parameters: The level
+      Returns: Nonzero if it has a power of two line and at least one set
+*/
+static int valid_geometry(struct Cachesim_geometry *g)
+{
+        return g->ways > 0 && g->line > 0 && (g->line & (g->line - 1)) == 0
+               && g->size / ((long)g->ways * g->line) > 0;
+}
+
+/* estimate
+      Purpose: Prices a case's counts: each access costs the latency of
+               every cache level it reaches, a miss in the last one a trip
+               to memory, and a TLB miss a page walk
+   Parameters: The simulator after the case, options, pixels moved
+      Returns: Estimated cycles per pixel
+*/
+static double estimate(Cachesim_T sim, struct Options *opts, double pixels)
+{
+        double cycles = 0;
+        for (int l = 0; l < Cachesim_levels(sim); l++) {
+                struct Cachesim_counts counts = Cachesim_counts(sim, l);
+                int latency = Cachesim_geometry(sim, l)->latency;
+                if (Cachesim_is_tlb(sim, l)) {
+                        cycles += (double)counts.misses * latency;
+                        continue;
+                }
+                cycles += (double)(counts.hits + counts.misses) * latency;
+                if (l == opts->ncaches - 1) {
+                        cycles += (double)counts.misses *
+                                  opts->memoryLatency;
+                }
+        }
+        return cycles / pixels;
+}
+
+/* rank
+      Purpose: Numbers the results of each transform from 1, cheapest
+               first; equal estimates share a rank
+   Parameters: The results, how many
+      Returns: None
+*/
+static void rank(struct Result *results, int n)
+{
+        for (int a = 0; a < n; a++) {
+                results[a].rank = 1;
+                for (int b = 0; b < n; b++) {
+                        if (results[b].d4 == results[a].d4 &&
+                            results[b].cycles < results[a].cycles) {
+                                results[a].rank++;
+                        }
+                }
+        }
+}
+
+/* report
+      Purpose: Prints one result as a CSV row or a JSON object
+   Parameters: Options, the simulator (for the level names), the result,
+               shape, cell size, whether this is the first result printed
+      Returns: None
+*/
+static void report(struct Options *opts, Cachesim_T sim, struct Result *r,
+                   int width, int height, int cell, int first)
+{
+        int levels = Cachesim_levels(sim);
+        if (opts->json) {
+                printf("%s\n  {\"layout\": \"%s\", \"traversal\": \"%s\", "
+                       "\"transform\": \"%s\", \"d4\": %d, \"width\": %d, "
+                       "\"height\": %d, \"cell\": %d, \"levels\": {",
+                       first ? "[" : ",", r->layout, r->traversal,
+                       D4_id(r->d4), r->d4, width, height, cell);
+                for (int l = 0; l < levels; l++) {
+                        printf("%s\"%s\": {\"hits\": %ld, \"misses\": %ld}",
+                               l > 0 ? ", " : "",
+                               Cachesim_geometry(sim, l)->name,
+                               r->counts[l].hits, r->counts[l].misses);
+                }
+                printf("}, \"cycles_per_pixel\": %.3f, \"rank\": %d}",
+                       r->cycles, r->rank);
+        } else {
+                printf("%s,%s,%s,%d,%d,%d,%d", r->layout, r->traversal,
+                       D4_id(r->d4), r->d4, width, height, cell);
+                for (int l = 0; l < levels; l++) {
+                        printf(",%ld,%ld", r->counts[l].hits,
+                               r->counts[l].misses);
+                }
+                printf(",%.3f,%d\n", r->cycles, r->rank);
+        }
+}
+
+/* run_all
+      Purpose: Simulates every layout, map and transform asked for on one
+               image shape and cell size, then ranks and reports them
+   Parameters: Options, the simulator, shape, cell size, whether nothing
+               has been printed yet
+      Returns: The updated "nothing printed yet" flag
+*/
+static int run_all(struct Options *opts, Cachesim_T sim, int width,
+                   int height, int cell, int first)
+{
+        struct Result *results = CALLOC(HARNESS_LAYOUTS * MAPS *
+                                        opts->cases.nd4s, sizeof(*results));
+        int n = 0;
+        for (int l = 0; l < HARNESS_LAYOUTS; l++) {
+                if (!Harness_wants(&opts->cases, l)) {
+                        continue;
+                }
+                A2Methods_T methods = *Harness_layouts[l].methods;
+                struct Harness_copy c;
+                c.methods = A2sim_methods(methods, sim);
+                A2Methods_mapfun *maps[MAPS] = {
+                        c.methods->map_row_major, c.methods->map_col_major,
+                        c.methods->map_block_major, c.methods->map_default
+                };
+                A2Methods_UArray2 source = methods->new(width, height, cell);
+                Harness_fill(methods, source);
+
+                /* A destination of each orientation, made on first use */
+                A2Methods_UArray2 dests[2] = { NULL, NULL };
+                for (int d = 0; d < opts->cases.nd4s; d++) {
+                        int d4 = opts->cases.d4s[d];
+                        c.transform = D4_transformation(d4);
+                        int swaps = D4_swaps_dimensions(d4) != 0;
+                        if (dests[swaps] == NULL) {
+                                dests[swaps] = methods->new(
+                                        swaps ? height : width,
+                                        swaps ? width : height, cell);
+                                Harness_fill(methods, dests[swaps]);
+                        }
+                        c.dest = dests[swaps];
+                        for (int m = 0; m < MAPS; m++) {
+                                if (maps[m] == NULL) {
+                                        continue;
+                                }
+                                struct Result *r = &results[n++];
+                                Cachesim_reset(sim);
+                                maps[m](source, Harness_copy_cell, &c);
+                                r->layout = Harness_layouts[l].name;
+                                r->traversal = mapNames[m];
+                                r->d4 = d4;
+                                for (int v = 0; v < Cachesim_levels(sim);
+                                     v++) {
+                                        r->counts[v] =
+                                                Cachesim_counts(sim, v);
+                                }
+                                r->cycles = estimate(sim, opts,
+                                                     (double)width * height);
+                        }
+                }
+                for (int s = 0; s < 2; s++) {
+                        if (dests[s] != NULL) {
+                                methods->free(&dests[s]);
+                        }
+                }
+                methods->free(&source);
+        }
+
+        rank(results, n);
+        for (int i = 0; i < n; i++) {
+                report(opts, sim, &results[i], width, height, cell, first);
+                first = 0;
+        }
+        fflush(stdout);
+        FREE(results);
+        return first;
+}
+
+int main(int argc, char *argv[])
+{
+        struct Options opts;
+        Harness_defaults(&opts.cases);
+        opts.cases.shapes = 1;
+        opts.cases.widths[0] = 1024;
+        opts.cases.heights[0] = 768;
+        default_caches(&opts);
+        opts.line = 64;
+        opts.memoryLatency = DEFAULT_MEMORY_LATENCY;
+        opts.json = 0;
+
+        for (int i = 1; i < argc; i++) {
+                if (Harness_option(&opts.cases, argc, argv, &i)) {
+                        continue;
+                }
+                int more = i + 1 < argc;
+                if (strcmp(argv[i], "-caches") == 0 && more) {
+                        parse_caches(argv[++i], &opts, argv[0]);
+                } else if (strcmp(argv[i], "-line") == 0 && more) {
+                        opts.line = parse_number(argv[++i], argv[0]);
+                } else if (strcmp(argv[i], "-tlb") == 0 && more) {
+                        parse_tlb(argv[++i], &opts, argv[0]);
+                } else if (strcmp(argv[i], "-memory") == 0 && more) {
+                        opts.memoryLatency = parse_number(argv[++i],
+                                                          argv[0]);
+                } else if (strcmp(argv[i], "-json") == 0) {
+                        opts.json = 1;
+                } else {
+                        usage(argv[0]);
+                }
+        }
+        if (!Harness_valid(&opts.cases) || opts.ncaches == 0) {
+                usage(argv[0]);
+        }
+        for (int l = 0; l < opts.ncaches; l++) {
+                opts.caches[l].line = opts.line;
+                if (!valid_geometry(&opts.caches[l])) {
+                        usage(argv[0]);
+                }
+        }
+        if (opts.hasTlb && !valid_geometry(&opts.tlb)) {
+                usage(argv[0]);
+        }
+
+        Cachesim_T sim = Cachesim_new(opts.ncaches, opts.caches,
+                                      opts.hasTlb ? &opts.tlb : NULL);
+        if (!opts.json) {
+                printf("layout,traversal,transform,d4,width,height,cell");
+                for (int l = 0; l < Cachesim_levels(sim); l++) {
+                        const char *name = Cachesim_geometry(sim, l)->name;
+                        printf(",%s_hits,%s_misses", name, name);
+                }
+                printf(",cycles_per_pixel,rank\n");
+        }
+        int first = 1;
+        struct Harness_cases *cases = &opts.cases;
+        for (int s = 0; s < cases->shapes; s++) {
+                for (int k = 0; k < cases->ncells; k++) {
+                        first = run_all(&opts, sim, cases->widths[s],
+                                        cases->heights[s], cases->cells[k],
+                                        first);
+                }
+        }
+        if (opts.json) {
+                printf(first ? "[]\n" : "\n]\n");
+        }
+
+        Cachesim_free(&sim);
+        return EXIT_SUCCESS;
+}
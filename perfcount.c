@@ -0,0 +1,168 @@
+/*******************************************************************
+ *       perfcount.c
+ *       BY Anesu Gavhera 03/05/2021
+ *
+ *       Implementation of Perfcount_T. Each event is opened with
+ *       perf_event_open for this process on any CPU, user space only
+ *       (which is all a perf_event_paranoid setting of 2 allows), and
+ *       joins the group of the first event that opened. The group is
+ *       reset and enabled by Start and disabled by Stop, which reads
+ *       every counter along with how long it was enabled and how long
+ *       it actually ran, to scale for multiplexing.
+ *
+ *****************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "assert.h"
+#include "perfcount.h"
+
+struct Perfcount {
+        int fds[PERFCOUNT_EVENTS];      /* -1 where the event did not open */
+        int leader;                     /* fd of the group leader, or -1 */
+};
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *              Forward declaration of functions
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+static int open_event(uint32_t type, uint64_t config, int group);
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *              The events, in the order of the PERFCOUNT_ indexes
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define CACHE_EVENT(CACHE, OP, RESULT) \
+        ((CACHE) | ((OP) << 8) | ((RESULT) << 16))
+
+static const struct {
+        uint32_t type;
+        uint64_t config;
+        const char *name;
+} events[PERFCOUNT_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles" },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions" },
+        { PERF_TYPE_HW_CACHE,
+          CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                      PERF_COUNT_HW_CACHE_RESULT_MISS), "l1d_misses" },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "llc_misses" },
+        { PERF_TYPE_HW_CACHE,
+          CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                      PERF_COUNT_HW_CACHE_RESULT_MISS), "dtlb_misses" },
+};
+
+#undef CACHE_EVENT
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *              Functions implementing the Perfcount interface
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+Perfcount_T Perfcount_New(void)
+{
+        Perfcount_T counters = malloc(sizeof(*counters));
+        assert(counters != NULL);
+        counters->leader = -1;
+        for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+                counters->fds[e] = open_event(events[e].type,
+                                              events[e].config,
+                                              counters->leader);
+                if (counters->leader < 0) {
+                        counters->leader = counters->fds[e];
+                }
+        }
+        return counters;
+}
+
+void Perfcount_Free(Perfcount_T *counterspp)
+{
+        assert(counterspp != NULL);
+        assert(*counterspp != NULL);
+        for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+                if ((*counterspp)->fds[e] >= 0) {
+                        close((*counterspp)->fds[e]);
+                }
+        }
+        free(*counterspp);
+        *counterspp = NULL;
+}
+
+void Perfcount_Start(Perfcount_T counters)
+{
+        assert(counters != NULL);
+        if (counters->leader < 0) {
+                return;
+        }
+        ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void Perfcount_Stop(Perfcount_T counters, struct Perfcount_values *values)
+{
+        assert(counters != NULL && values != NULL);
+        if (counters->leader >= 0) {
+                ioctl(counters->leader, PERF_EVENT_IOC_DISABLE,
+                      PERF_IOC_FLAG_GROUP);
+        }
+
+        for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+                /* value, time enabled, time running */
+                uint64_t data[3];
+                values->count[e] = -1;
+                if (counters->fds[e] < 0 ||
+                    read(counters->fds[e], data, sizeof(data)) !=
+                    (ssize_t)sizeof(data) || data[2] == 0) {
+                        continue;
+                }
+                values->count[e] = (double)data[0] * data[1] / data[2];
+        }
+}
+
+int Perfcount_Available(Perfcount_T counters)
+{
+        assert(counters != NULL);
+        int n = 0;
+        for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+                n += counters->fds[e] >= 0;
+        }
+        return n;
+}
+
+const char *Perfcount_Name(int event)
+{
+        assert(0 <= event && event < PERFCOUNT_EVENTS);
+        return events[event].name;
+}
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *     Utility functions called internally
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/*
+ *  open_event
+ *
+ *  Opens one counter for this process and the threads it goes on to
+ *  create, in user space only. The group leader starts disabled, and
+ *  the others follow it. Returns the file descriptor, or -1 if the
+ *  event cannot be counted here.
+ */
+static int open_event(uint32_t type, uint64_t config, int group)
+{
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group < 0;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+        return fd < 0 ? -1 : (int)fd;
+}
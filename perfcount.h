@@ -0,0 +1,71 @@
+/*******************************************************************
+ *       perfcount.h
+ *       BY Anesu Gavhera 03/05/2021
+ *
+ *       Interface to functions implementing type Perfcount_T, a
+ *       companion to CPUTime_T that counts hardware events (cycles,
+ *       instructions, cache and TLB misses) over the same kind of
+ *       Start/Stop region, using the kernel's perf_event counters.
+ *
+ *       Usage:
+ *
+ *       Perfcount_T counters = Perfcount_New();
+ *       Perfcount_Start(counters);
+ *         ... Do work to be measured here
+ *       struct Perfcount_values counts;
+ *       Perfcount_Stop(counters, &counts);
+ *
+ *       Counters are opened as one group so that they count the same
+ *       instructions, and also count threads the calling thread
+ *       creates after Perfcount_New. An event the machine does not
+ *       have, or that the kernel will not let this process count (see
+ *       /proc/sys/kernel/perf_event_paranoid), reads as negative;
+ *       if no event is available at all, every count is negative and
+ *       the work still runs normally.
+ *
+ *****************************************************************/
+#ifndef PERFCOUNT_INCLUDED
+#define PERFCOUNT_INCLUDED
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *                   Type definitions
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+typedef struct Perfcount *Perfcount_T;
+
+/* The events counted, as indexes into Perfcount_values */
+enum {
+        PERFCOUNT_CYCLES,
+        PERFCOUNT_INSTRUCTIONS,
+        PERFCOUNT_L1D_MISSES,           /* level 1 data cache read misses */
+        PERFCOUNT_LLC_MISSES,           /* last level cache misses */
+        PERFCOUNT_DTLB_MISSES,          /* data TLB read misses */
+        PERFCOUNT_EVENTS
+};
+
+/* Counts from one region, negative for events that were not counted.
+   If the kernel had to share the hardware counters with other groups,
+   the counts are scaled up to the whole region */
+struct Perfcount_values {
+        double count[PERFCOUNT_EVENTS];
+};
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *              Functions implementing the Perfcount interface
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+Perfcount_T Perfcount_New(void);
+
+void Perfcount_Free(Perfcount_T *counterspp);
+
+void Perfcount_Start(Perfcount_T counters);
+
+void Perfcount_Stop(Perfcount_T counters, struct Perfcount_values *values);
+
+/* returns how many of the PERFCOUNT_EVENTS events could be opened */
+int Perfcount_Available(Perfcount_T counters);
+
+/* returns a short name for an event, such as "llc_misses" */
+const char *Perfcount_Name(int event);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ *     planar.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of planar images: three arrays behind one handle.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stddef.h>
+#include "assert.h"
+#include "mem.h"
+#include "planar.h"
+
+#define T Planar_T
+
+struct T {
+        A2Methods_T methods;
+        int channelSize;
+        A2Methods_UArray2 planes[PLANAR_CHANNELS];
+};
+
+T Planar_new(A2Methods_T methods, int width, int height, int channelSize)
+{
+        assert(methods != NULL);
+        assert(channelSize == 1 || channelSize == 2);
+
+        T planar;
+        NEW(planar);
+        planar->methods = methods;
+        planar->channelSize = channelSize;
+        for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                planar->planes[c] = methods->new(width, height, channelSize);
+        }
+        return planar;
+}
+
+void Planar_free(T *planar)
+{
+        assert(planar != NULL && *planar != NULL);
+        for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                (*planar)->methods->free(&(*planar)->planes[c]);
+        }
+        FREE(*planar);
+}
+
+A2Methods_T Planar_methods(T planar)
+{
+        assert(planar != NULL);
+        return planar->methods;
+}
+
+int Planar_width(T planar)
+{
+        assert(planar != NULL);
+        return planar->methods->width(planar->planes[0]);
+}
+
+int Planar_height(T planar)
+{
+        assert(planar != NULL);
+        return planar->methods->height(planar->planes[0]);
+}
+
+int Planar_channel_size(T planar)
+{
+        assert(planar != NULL);
+        return planar->channelSize;
+}
+
+A2Methods_UArray2 Planar_plane(T planar, int channel)
+{
+        assert(planar != NULL);
+        assert(channel >= 0 && channel < PLANAR_CHANNELS);
+        return planar->planes[channel];
+}
+
+#undef T
@@ -0,0 +1,52 @@
+/*
+ *     planar.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for planar (structure-of-arrays) images. Instead of one
+ *     array of interleaved red, green and blue cells, a planar image keeps
+ *     one array per channel, all three made by the same A2Methods and of
+ *     the same width and height. Cells are 1-byte channels (uint8_t) when
+ *     the image's denominator is at most 255 and 2-byte ones (uint16_t)
+ *     otherwise.
+ *
+ *     Geometric transforms move each plane on its own (ppmtrans hands the
+ *     planes to its engines one at a time), so they always move uniform 1-
+ *     or 2-byte lanes. A point operation on one channel maps
+ *     over that channel's plane with the plane's methods and never touches
+ *     the other two.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef PLANAR_INCLUDED
+#define PLANAR_INCLUDED
+
+#include "a2methods.h"
+
+#define T Planar_T
+typedef struct T *T;
+
+/* Channels, in the order of a ppm's samples */
+#define PLANAR_RED      0
+#define PLANAR_GREEN    1
+#define PLANAR_BLUE     2
+#define PLANAR_CHANNELS 3
+
+/* creates an image of three width x height planes of channelSize-byte
+ * cells (1 or 2) using methods; anything else is a checked run-time error
+ */
+extern T Planar_new(A2Methods_T methods, int width, int height,
+                    int channelSize);
+extern void Planar_free(T *planar);
+
+extern A2Methods_T Planar_methods(T planar);
+extern int Planar_width(T planar);
+extern int Planar_height(T planar);
+extern int Planar_channel_size(T planar);
+
+/* returns the array holding one channel; map over it with
+ * Planar_methods(planar) to work on that channel alone
+ */
+extern A2Methods_UArray2 Planar_plane(T planar, int channel);
+
+#undef T
+#endif
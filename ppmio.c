@@ -0,0 +1,579 @@
+/*
+ *     ppmio.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of bulk ppm input and output. Channels are one byte
+ *     when the denominator is below 256 and two bytes, most significant
+ *     first, otherwise. Packed cells hold the channel bytes just as the
+ *     file does, so they are copied without decoding; padded cells add
+ *     one channel's width of zeros. A row is decoded straight into the
+ *     pixel array wherever a run of its cells is contiguous in the layout
+ *     (a whole row for the plain layout, one block wide for the blocked
+ *     one) and through methods->at elsewhere.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <mem.h>
+#include "assert.h"
+#include "ppmio.h"
+#include "trace.h"
+
+/* Bytes of encoded rows gathered before each write */
+#define WRITE_BUFFER (256 * 1024)
+
+/*  parse_number
+ *
+ *  Purpose: Parses one unsigned decimal field of a ppm header, skipping
+ *           the whitespace and '#' comments before it
+ *
+ *  Parameters: pointer to the read position, end of the data
+ *
+ *  Returns: The number read; the read position is moved past it
+ *
+ *  Errors: raises Pnm_Badformat if no number is found or it is above
+ *          INT_MAX
+ */
+static unsigned parse_number(const unsigned char **pos,
+                             const unsigned char *end)
+{
+        const unsigned char *p = *pos;
+        while (p < end && (isspace(*p) || *p == '#')) {
+                if (*p == '#') {
+                        while (p < end && *p != '\n') {
+                                p++;
+                        }
+                } else {
+                        p++;
+                }
+        }
+        if (p == end || !isdigit(*p)) {
+                RAISE(Pnm_Badformat);
+        }
+
+        unsigned n = 0;
+        while (p < end && isdigit(*p)) {
+                unsigned digit = *p - '0';
+                if (n > (INT_MAX - digit) / 10) {
+                        RAISE(Pnm_Badformat);
+                }
+                n = n * 10 + digit;
+                p++;
+        }
+        *pos = p;
+        return n;
+}
+
+/* Decodes n pixels of 'wide' (two-byte) or one-byte channels from raw
+   into cells of the given size */
+static inline void decode_run(const unsigned char *raw, char *cells, int n,
+                              int wide, int size)
+{
+        int bytes = wide ? 6 : 3;
+        if (size == bytes) {                    /* packed: as in the file */
+                memcpy(cells, raw, (size_t)n * bytes);
+        } else if (size != sizeof(struct Pnm_rgb)) {    /* padded */
+                for (int i = 0; i < n; i++, raw += bytes, cells += size) {
+                        memcpy(cells, raw, bytes);
+                        memset(cells + bytes, 0, size - bytes);
+                }
+        } else if (wide) {
+                struct Pnm_rgb *dst = (struct Pnm_rgb *)cells;
+                for (int i = 0; i < n; i++, raw += 6) {
+                        dst[i].red   = raw[0] << 8 | raw[1];
+                        dst[i].green = raw[2] << 8 | raw[3];
+                        dst[i].blue  = raw[4] << 8 | raw[5];
+                }
+        } else {
+                struct Pnm_rgb *dst = (struct Pnm_rgb *)cells;
+                for (int i = 0; i < n; i++, raw += 3) {
+                        dst[i].red   = raw[0];
+                        dst[i].green = raw[1];
+                        dst[i].blue  = raw[2];
+                }
+        }
+}
+
+/* Encodes n pixels from cells of the given size into 'wide' (two-byte) or
+   one-byte channels */
+static inline void encode_run(const char *cells, unsigned char *raw, int n,
+                              int wide, int size)
+{
+        int bytes = wide ? 6 : 3;
+        if (size == bytes) {
+                memcpy(raw, cells, (size_t)n * bytes);
+        } else if (size != sizeof(struct Pnm_rgb)) {
+                for (int i = 0; i < n; i++, raw += bytes, cells += size) {
+                        memcpy(raw, cells, bytes);
+                }
+        } else if (wide) {
+                const struct Pnm_rgb *src = (const struct Pnm_rgb *)cells;
+                for (int i = 0; i < n; i++, raw += 6) {
+                        raw[0] = src[i].red >> 8;
+                        raw[1] = src[i].red;
+                        raw[2] = src[i].green >> 8;
+                        raw[3] = src[i].green;
+                        raw[4] = src[i].blue >> 8;
+                        raw[5] = src[i].blue;
+                }
+        } else {
+                const struct Pnm_rgb *src = (const struct Pnm_rgb *)cells;
+                for (int i = 0; i < n; i++, raw += 3) {
+                        raw[0] = src[i].red;
+                        raw[1] = src[i].green;
+                        raw[2] = src[i].blue;
+                }
+        }
+}
+
+/* Decodes n pixels from raw into cells, or encodes them from cells into
+   raw if decode is zero */
+static inline void move_run(unsigned char *raw, char *cells, int n,
+                            int wide, int size, int decode)
+{
+        if (decode) {
+                decode_run(raw, cells, n, wide, size);
+        } else {
+                encode_run(cells, raw, n, wide, size);
+        }
+}
+
+/* Returns the number of cells of row that are stored together, from the
+   left, in runs: the whole row unless the array is blocked */
+static int run_length(const struct A2Methods_T *methods,
+                      A2Methods_UArray2 array2)
+{
+        int width = methods->width(array2);
+        int blocksize = methods->blocksize(array2);
+        return blocksize > 1 && blocksize < width ? blocksize : width;
+}
+
+/* Returns the address of the n cells from (col, row) if they are
+   contiguous in array2, else NULL */
+static char *contiguous_run(const struct A2Methods_T *methods,
+                            A2Methods_UArray2 array2, int col, int row, int n)
+{
+        char *first = methods->at(array2, col, row);
+        char *last = methods->at(array2, col + n - 1, row);
+        return last - first == (long)(n - 1) * methods->size(array2)
+               ? first : NULL;
+}
+
+/*  convert_rows
+ *
+ *  Purpose: Moves every pixel between a raw raster and the pixel array, a
+ *           run of cells at a time
+ *
+ *  Parameters: the image, raster of its rows back to back, channel width,
+ *              nonzero to fill the array from the raster (else the other
+ *              way), first and last + 1 rows to move
+ *
+ *  Returns: None
+ */
+static void convert_rows(Pnm_ppm ppm, unsigned char *raster, int wide,
+                         int decode, int row0, int row1)
+{
+        const struct A2Methods_T *methods = ppm->methods;
+        int width = ppm->width;
+        int bytes = wide ? 6 : 3;
+        int size = methods->size(ppm->pixels);
+        int run = run_length(methods, ppm->pixels);
+
+        for (int row = row0; row < row1; row++) {
+                unsigned char *raw = raster +
+                                     (size_t)(row - row0) * width * bytes;
+                for (int col = 0; col < width; col += run) {
+                        int n = col + run < width ? run : width - col;
+                        char *cells = contiguous_run(methods, ppm->pixels,
+                                                     col, row, n);
+                        if (cells != NULL) {
+                                move_run(raw + col * bytes, cells, n, wide,
+                                         size, decode);
+                                continue;
+                        }
+                        for (int i = 0; i < n; i++) {   /* one at a time */
+                                move_run(raw + (col + i) * bytes,
+                                         methods->at(ppm->pixels, col + i,
+                                                     row),
+                                         1, wide, size, decode);
+                        }
+                }
+        }
+}
+
+/* Returns nonzero if cells of the given size hold pixels whose channels
+   are two bytes wide when that flag is set */
+static int valid_size(int size, int wide)
+{
+        int bytes = wide ? 6 : 3;
+        return size == sizeof(struct Pnm_rgb) || size == bytes ||
+               size == bytes + bytes / 3;
+}
+
+int Ppmio_pixel_size(Ppmio_pixel pixel, unsigned denominator)
+{
+        int bytes = denominator > 255 ? 6 : 3;
+        switch (pixel) {
+        case PPMIO_RGB:    return sizeof(struct Pnm_rgb);
+        case PPMIO_PACKED: return bytes;
+        case PPMIO_PADDED: return bytes + bytes / 3;
+        }
+        assert(0);
+        return 0;
+}
+
+/*  read_with_pnm
+ *
+ *  Purpose: Reads an image that cannot be mapped with Pnm_ppmread, then
+ *           repacks its pixels if another format or an arena was asked for
+ *
+ *  Parameters: input file, methods for the pixel array, pixel format,
+ *              allocator for the image
+ *
+ *  Returns: The image
+ */
+static Pnm_ppm read_with_pnm(FILE *fp, A2Methods_T methods,
+                             Ppmio_pixel pixel, Alloc_T alloc)
+{
+        Pnm_ppm ppm = Pnm_ppmread(fp, methods);
+        int size = Ppmio_pixel_size(pixel, ppm->denominator);
+        if (size == sizeof(struct Pnm_rgb) && alloc == NULL) {
+                return ppm;
+        }
+
+        int wide = ppm->denominator > 255;
+        unsigned char raw[6];
+        A2Methods_UArray2 cells = methods->new_with_allocator(ppm->width,
+                                        ppm->height, size, 0, alloc);
+        for (int row = 0; row < (int)ppm->height; row++) {
+                for (int col = 0; col < (int)ppm->width; col++) {
+                        encode_run(methods->at(ppm->pixels, col, row), raw, 1,
+                                   wide, sizeof(struct Pnm_rgb));
+                        decode_run(raw, methods->at(cells, col, row), 1,
+                                   wide, size);
+                }
+        }
+        Pnm_ppm copy = Alloc_alloc(alloc, sizeof(*copy));
+        *copy = *ppm;
+        copy->pixels = cells;
+        Pnm_ppmfree(&ppm);
+        return copy;
+}
+
+/* A raw image mapped from its file */
+struct Mapped {
+        unsigned char *map;
+        size_t length;
+        const unsigned char *raster;    /* first pixel */
+        unsigned width, height, denominator;
+};
+
+/* Returns the number of bytes of pixels in a mapped image */
+static size_t raster_bytes(struct Mapped *m)
+{
+        return (size_t)m->width * m->height * (m->denominator > 255 ? 6 : 3);
+}
+
+/*  map_image
+ *
+ *  Purpose: Maps the image at the read position of fp and parses its
+ *           header
+ *
+ *  Parameters: input file, mapping to fill in
+ *
+ *  Returns: 1 if the image is mapped; 0 if it must be read some other way
+ *           (fp cannot be mapped, or the image is not raw)
+ *
+ *  Errors: raises Pnm_Badformat if the image is malformed or truncated
+ */
+static int map_image(FILE *fp, struct Mapped *m)
+{
+        /* Pipes and the like cannot be mapped */
+        struct stat st;
+        off_t start = ftello(fp);
+        if (start < 0 || fstat(fileno(fp), &st) != 0 ||
+            !S_ISREG(st.st_mode) || st.st_size <= start) {
+                return 0;
+        }
+        m->length = st.st_size;
+        m->map = mmap(NULL, m->length, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+        if (m->map == MAP_FAILED) {
+                return 0;
+        }
+        const unsigned char *pos = m->map + start;
+        const unsigned char *end = m->map + m->length;
+        if (end - pos < 2 || pos[0] != 'P' || pos[1] != '6') {
+                munmap(m->map, m->length);
+                return 0;
+        }
+        pos += 2;
+        madvise(m->map, m->length, MADV_SEQUENTIAL);
+
+        /* Header */
+        m->width = parse_number(&pos, end);
+        m->height = parse_number(&pos, end);
+        m->denominator = parse_number(&pos, end);
+        if (m->width == 0 || m->height == 0 || m->denominator == 0 ||
+            m->denominator > 65535 || pos == end || !isspace(*pos)) {
+                munmap(m->map, m->length);
+                RAISE(Pnm_Badformat);
+        }
+        pos++;
+
+        /* Checked by division, as the product may not fit in a size_t */
+        size_t pixels = (size_t)(end - pos) / (m->denominator > 255 ? 6 : 3);
+        if (pixels / m->width < m->height) {
+                munmap(m->map, m->length);
+                RAISE(Pnm_Badformat);
+        }
+        m->raster = pos;
+        return 1;
+}
+
+/* Unmaps an image, leaving fp just past it as Pnm_ppmread would */
+static void unmap_image(FILE *fp, struct Mapped *m)
+{
+        off_t after = (m->raster - m->map) + raster_bytes(m);
+        munmap(m->map, m->length);
+        fseeko(fp, after, SEEK_SET);
+}
+
+Pnm_ppm Ppmio_read(FILE *fp, A2Methods_T methods, Ppmio_pixel pixel,
+                   Alloc_T alloc)
+{
+        assert(fp != NULL && methods != NULL);
+
+        struct Mapped m;
+        long span = Trace_begin();
+        if (!map_image(fp, &m)) {
+                Pnm_ppm ppm = read_with_pnm(fp, methods, pixel, alloc);
+                Trace_end("parse", span, 0);
+                return ppm;
+        }
+        Trace_end("parse", span, 0);
+
+        span = Trace_begin();
+        Pnm_ppm ppm = Alloc_alloc(alloc, sizeof(*ppm));
+        ppm->width = m.width;
+        ppm->height = m.height;
+        ppm->denominator = m.denominator;
+        ppm->methods = methods;
+        ppm->pixels = methods->new_with_allocator(m.width, m.height,
+                                Ppmio_pixel_size(pixel, m.denominator), 0,
+                                alloc);
+        Trace_end("allocate", span, 0);
+
+        span = Trace_begin();
+        convert_rows(ppm, (unsigned char *)m.raster, m.denominator > 255, 1,
+                     0, m.height);
+        unmap_image(fp, &m);
+        Trace_end("decode", span, m.height);
+        return ppm;
+}
+
+/* Writes n bytes of buf to fp. A short write frees buf and raises
+   Pnm_Badformat, as a short read does. */
+static void write_raster(FILE *fp, unsigned char *buf, size_t n)
+{
+        if (fwrite(buf, 1, n, fp) != n) {
+                FREE(buf);
+                RAISE(Pnm_Badformat);
+        }
+}
+
+void Ppmio_write(FILE *fp, Pnm_ppm ppm)
+{
+        assert(fp != NULL && ppm != NULL);
+        int wide = ppm->denominator > 255;
+        assert(valid_size(ppm->methods->size(ppm->pixels), wide));
+        size_t rowBytes = (size_t)ppm->width * (wide ? 6 : 3);
+        int rows = WRITE_BUFFER / rowBytes > 0 ? WRITE_BUFFER / rowBytes : 1;
+        if (fprintf(fp, "P6\n%u %u\n%u\n", ppm->width, ppm->height,
+                    ppm->denominator) < 0) {
+                RAISE(Pnm_Badformat);
+        }
+        unsigned char *buf = ALLOC(rows * rowBytes);
+        for (int row0 = 0; row0 < (int)ppm->height; row0 += rows) {
+                int row1 = row0 + rows < (int)ppm->height ? row0 + rows
+                                                          : (int)ppm->height;
+                long span = Trace_begin();
+                convert_rows(ppm, buf, wide, 0, row0, row1);
+                Trace_end("encode", span, row0);
+                span = Trace_begin();
+                write_raster(fp, buf, (row1 - row0) * rowBytes);
+                Trace_end("write", span, row0);
+        }
+        FREE(buf);
+        if (fflush(fp) != 0) {
+                RAISE(Pnm_Badformat);
+        }
+}
+
+/* Splits n interleaved pixels from raw into the three planes' cells, or
+   merges them back into raw if decode is zero. Two-byte channels are
+   stored as native uint16_t. */
+static inline void planar_run(unsigned char *raw, char **cells, int n,
+                              int wide, int decode)
+{
+        if (wide) {
+                uint16_t *r = (uint16_t *)cells[PLANAR_RED];
+                uint16_t *g = (uint16_t *)cells[PLANAR_GREEN];
+                uint16_t *b = (uint16_t *)cells[PLANAR_BLUE];
+                for (int i = 0; i < n; i++, raw += 6) {
+                        if (decode) {
+                                r[i] = raw[0] << 8 | raw[1];
+                                g[i] = raw[2] << 8 | raw[3];
+                                b[i] = raw[4] << 8 | raw[5];
+                        } else {
+                                raw[0] = r[i] >> 8;
+                                raw[1] = r[i];
+                                raw[2] = g[i] >> 8;
+                                raw[3] = g[i];
+                                raw[4] = b[i] >> 8;
+                                raw[5] = b[i];
+                        }
+                }
+                return;
+        }
+        uint8_t *r = (uint8_t *)cells[PLANAR_RED];
+        uint8_t *g = (uint8_t *)cells[PLANAR_GREEN];
+        uint8_t *b = (uint8_t *)cells[PLANAR_BLUE];
+        if (decode) {
+                for (int i = 0; i < n; i++, raw += 3) {
+                        r[i] = raw[0];
+                        g[i] = raw[1];
+                        b[i] = raw[2];
+                }
+        } else {
+                for (int i = 0; i < n; i++, raw += 3) {
+                        raw[0] = r[i];
+                        raw[1] = g[i];
+                        raw[2] = b[i];
+                }
+        }
+}
+
+/*  convert_planar_rows
+ *
+ *  Purpose: As convert_rows, for a planar image. The planes share one
+ *           layout, so a run contiguous in one is contiguous in all.
+ */
+static void convert_planar_rows(Planar_T planar, unsigned char *raster,
+                                int wide, int decode, int row0, int row1)
+{
+        A2Methods_T methods = Planar_methods(planar);
+        A2Methods_UArray2 planes[PLANAR_CHANNELS];
+        for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                planes[c] = Planar_plane(planar, c);
+        }
+        int width = Planar_width(planar);
+        int bytes = wide ? 6 : 3;
+        int run = run_length(methods, planes[0]);
+        char *cells[PLANAR_CHANNELS];
+
+        for (int row = row0; row < row1; row++) {
+                unsigned char *raw = raster +
+                                     (size_t)(row - row0) * width * bytes;
+                for (int col = 0; col < width; col += run) {
+                        int n = col + run < width ? run : width - col;
+                        if (contiguous_run(methods, planes[0], col, row, n)) {
+                                for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                                        cells[c] = methods->at(planes[c],
+                                                               col, row);
+                                }
+                                planar_run(raw + col * bytes, cells, n, wide,
+                                           decode);
+                                continue;
+                        }
+                        for (int i = 0; i < n; i++) {   /* one at a time */
+                                for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                                        cells[c] = methods->at(planes[c],
+                                                               col + i, row);
+                                }
+                                planar_run(raw + (col + i) * bytes, cells, 1,
+                                           wide, decode);
+                        }
+                }
+        }
+}
+
+Planar_T Ppmio_read_planar(FILE *fp, A2Methods_T methods,
+                           unsigned *denominator)
+{
+        assert(fp != NULL && methods != NULL && denominator != NULL);
+
+        struct Mapped m;
+        long span = Trace_begin();
+        if (map_image(fp, &m)) {
+                Trace_end("parse", span, 0);
+                *denominator = m.denominator;
+                span = Trace_begin();
+                Planar_T planar = Planar_new(methods, m.width, m.height,
+                                             m.denominator > 255 ? 2 : 1);
+                Trace_end("allocate", span, 0);
+                span = Trace_begin();
+                convert_planar_rows(planar, (unsigned char *)m.raster,
+                                    m.denominator > 255, 1, 0, m.height);
+                unmap_image(fp, &m);
+                Trace_end("decode", span, m.height);
+                return planar;
+        }
+
+        /* Split the pixels of an image read with Pnm_ppmread */
+        Pnm_ppm ppm = Pnm_ppmread(fp, methods);
+        int wide = ppm->denominator > 255;
+        unsigned char raw[6];
+        char *cells[PLANAR_CHANNELS];
+        *denominator = ppm->denominator;
+        Planar_T planar = Planar_new(methods, ppm->width, ppm->height,
+                                     wide ? 2 : 1);
+        for (int row = 0; row < (int)ppm->height; row++) {
+                for (int col = 0; col < (int)ppm->width; col++) {
+                        encode_run(methods->at(ppm->pixels, col, row), raw, 1,
+                                   wide, sizeof(struct Pnm_rgb));
+                        for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                                cells[c] = methods->at(Planar_plane(planar, c),
+                                                       col, row);
+                        }
+                        planar_run(raw, cells, 1, wide, 1);
+                }
+        }
+        Pnm_ppmfree(&ppm);
+        Trace_end("parse", span, 0);
+        return planar;
+}
+
+void Ppmio_write_planar(FILE *fp, Planar_T planar, unsigned denominator)
+{
+        assert(fp != NULL && planar != NULL);
+        int wide = denominator > 255;
+        assert(Planar_channel_size(planar) == (wide ? 2 : 1));
+
+        int width = Planar_width(planar);
+        int height = Planar_height(planar);
+        size_t rowBytes = (size_t)width * (wide ? 6 : 3);
+        int rows = WRITE_BUFFER / rowBytes > 0 ? WRITE_BUFFER / rowBytes : 1;
+        if (fprintf(fp, "P6\n%u %u\n%u\n", width, height, denominator) < 0) {
+                RAISE(Pnm_Badformat);
+        }
+        unsigned char *buf = ALLOC(rows * rowBytes);
+        for (int row0 = 0; row0 < height; row0 += rows) {
+                int row1 = row0 + rows < height ? row0 + rows : height;
+                long span = Trace_begin();
+                convert_planar_rows(planar, buf, wide, 0, row0, row1);
+                Trace_end("encode", span, row0);
+                span = Trace_begin();
+                write_raster(fp, buf, (row1 - row0) * rowBytes);
+                Trace_end("write", span, row0);
+        }
+        FREE(buf);
+        if (fflush(fp) != 0) {
+                RAISE(Pnm_Badformat);
+        }
+}
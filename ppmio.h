@@ -0,0 +1,106 @@
+/*
+ *     ppmio.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for reading and writing raw (P6) ppm images in bulk. The
+ *     reader maps the input file into memory and decodes a row of pixels
+ *     at a time into whatever layout the methods give, and the writer
+ *     encodes many rows into one buffer before each write, instead of
+ *     going through the per-pixel calls of Pnm_ppmread and Pnm_ppmwrite.
+ *
+ *     Pixels can be kept as struct Pnm_rgb (12 bytes) or in a compact
+ *     form: packed, three channels of one byte (two bytes if the
+ *     denominator is above 255) in file order, or padded, the same with a
+ *     fourth, zero channel so that a pixel is 4 (or 8) aligned bytes.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef PPMIO_INCLUDED
+#define PPMIO_INCLUDED
+
+#include <stdio.h>
+#include "a2methods.h"
+#include "pnm.h"
+#include "planar.h"
+#include "alloc.h"
+
+/* Formats of the pixels in the arrays Ppmio_read makes */
+typedef enum Ppmio_pixel {
+        PPMIO_RGB,              /* struct Pnm_rgb */
+        PPMIO_PACKED,           /* 3 or 6 bytes */
+        PPMIO_PADDED            /* 4 or 8 bytes */
+} Ppmio_pixel;
+
+/* returns the size in bytes of a pixel in the given format for an image
+ * with the given denominator
+ */
+extern int Ppmio_pixel_size(Ppmio_pixel pixel, unsigned denominator);
+
+/*  Ppmio_read
+ *
+ *  Purpose: Reads a ppm image into a new array of pixels
+ *
+ *  Parameters:
+ *
+ *    fp:      file positioned at the start of the image
+ *    methods: methods used to make the pixel array
+ *    pixel:   format of the pixels in the array
+ *    alloc:   allocator for the image and its pixels, or NULL for the
+ *             heap
+ *
+ *  Returns: The image, to be freed with Pnm_ppmfree if alloc is NULL
+ *
+ *  Notes: images that are not raw, or files that cannot be mapped (pipes),
+ *         are read with Pnm_ppmread
+ *
+ *  Errors: raises Pnm_Badformat if the image is malformed or truncated, or
+ *          its width or height is above INT_MAX
+ */
+extern Pnm_ppm Ppmio_read(FILE *fp, A2Methods_T methods, Ppmio_pixel pixel,
+                          Alloc_T alloc);
+
+/*  Ppmio_write
+ *
+ *  Purpose: Writes an image as a raw ppm
+ *
+ *  Parameters: file to write to, image to write
+ *
+ *  Returns: None
+ *
+ *  Errors: checked runtime error if the size of the image's cells is not
+ *          that of a Ppmio_pixel format for its denominator; raises
+ *          Pnm_Badformat if fp cannot take the whole image
+ */
+extern void Ppmio_write(FILE *fp, Pnm_ppm ppm);
+
+/*  Ppmio_read_planar
+ *
+ *  Purpose: Reads a ppm image into a new planar image
+ *
+ *  Parameters: file positioned at the start of the image, methods used to
+ *              make the planes, where to store the image's denominator
+ *
+ *  Returns: The image, with 1-byte channels if the denominator is at most
+ *           255 and 2-byte ones otherwise
+ *
+ *  Errors: as for Ppmio_read
+ */
+extern Planar_T Ppmio_read_planar(FILE *fp, A2Methods_T methods,
+                                  unsigned *denominator);
+
+/*  Ppmio_write_planar
+ *
+ *  Purpose: Writes a planar image as a raw ppm
+ *
+ *  Parameters: file to write to, image to write, its denominator
+ *
+ *  Returns: None
+ *
+ *  Errors: checked runtime error if the channel size does not match the
+ *          denominator; raises Pnm_Badformat if fp cannot take the whole
+ *          image
+ */
+extern void Ppmio_write_planar(FILE *fp, Planar_T planar,
+                               unsigned denominator);
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ *     ppmstream.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of streamed ppm transforms. The header is parsed
+ *     here rather than by Pnm_ppmread, since that reads every pixel before
+ *     returning. Each row is read into a single buffer, reversed in place
+ *     if the columns are mirrored, and either written straight out or, if
+ *     the rows are mirrored, pushed onto a temporary file that is then read
+ *     back from its last row to its first.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <string.h>
+#include <ctype.h>
+#include <mem.h>
+#include "assert.h"
+#include "pnm.h"
+#include "ppmstream.h"
+
+/*  read_number
+ *
+ *  Purpose: Reads one unsigned decimal field of a ppm header, skipping
+ *           the whitespace and '#' comments before it
+ *
+ *  Parameters: input file
+ *
+ *  Returns: The number read
+ *
+ *  Errors: raises Pnm_Badformat if no number is found
+ */
+static unsigned read_number(FILE *in)
+{
+        int c = getc(in);
+        while (isspace(c) || c == '#') {
+                if (c == '#') {
+                        while (c != '\n' && c != EOF) {
+                                c = getc(in);
+                        }
+                }
+                c = getc(in);
+        }
+        if (!isdigit(c)) {
+                RAISE(Pnm_Badformat);
+        }
+
+        unsigned n = 0;
+        while (isdigit(c)) {
+                n = n * 10 + (c - '0');
+                c = getc(in);
+        }
+        ungetc(c, in);
+        return n;
+}
+
+/* Reverses the order of the width pixels of 'bytes' bytes each in row */
+static void reverse_pixels(unsigned char *row, unsigned width, int bytes)
+{
+        unsigned char tmp[6];
+        unsigned char *left = row;
+        unsigned char *right = row + (size_t)(width - 1) * bytes;
+        while (left < right) {
+                memcpy(tmp, left, bytes);
+                memcpy(left, right, bytes);
+                memcpy(right, tmp, bytes);
+                left += bytes;
+                right -= bytes;
+        }
+}
+
+/* Reads one row into buf, raising Pnm_Badformat if the image ends early */
+static void read_row(FILE *in, unsigned char *buf, size_t rowBytes)
+{
+        if (fread(buf, 1, rowBytes, in) != rowBytes) {
+                RAISE(Pnm_Badformat);
+        }
+}
+
+int Ppmstream_supports(int d4)
+{
+        assert(d4 >= 0 && d4 < 8);
+        return !D4_swaps_dimensions(d4);
+}
+
+int Ppmstream_raw(FILE *in)
+{
+        assert(in != NULL);
+
+        /* A regular file goes back to where it was; a pipe gets the bytes
+           pushed back, last first */
+        off_t start = ftello(in);
+        int first = getc(in);
+        int second = first == EOF ? EOF : getc(in);
+        int restored = 1;
+        if (start >= 0) {
+                restored = fseeko(in, start, SEEK_SET) == 0;
+        } else {
+                if (second != EOF) {
+                        restored = ungetc(second, in) != EOF;
+                }
+                if (first != EOF) {
+                        restored = restored && ungetc(first, in) != EOF;
+                }
+        }
+        assert(restored);
+        return first == 'P' && second == '6';
+}
+
+void Ppmstream_transform(FILE *in, FILE *out, int d4, unsigned *width,
+                         unsigned *height)
+{
+        assert(in != NULL && out != NULL && width != NULL && height != NULL);
+        assert(Ppmstream_supports(d4));
+
+        /* Header */
+        if (getc(in) != 'P' || getc(in) != '6') {
+                RAISE(Pnm_Badformat);
+        }
+        *width = read_number(in);
+        *height = read_number(in);
+        unsigned maxval = read_number(in);
+        if (*width == 0 || *height == 0 || maxval == 0 || maxval > 65535 ||
+            !isspace(getc(in))) {
+                RAISE(Pnm_Badformat);
+        }
+        fprintf(out, "P6\n%u %u\n%u\n", *width, *height, maxval);
+
+        /* One channel is one byte, or two if maxval needs them */
+        int bytes = maxval < 256 ? 3 : 6;
+        size_t rowBytes = (size_t)*width * bytes;
+        unsigned char *buf = ALLOC(rowBytes);
+        int flipCol = (d4 & D4_FLIP_COL) != 0;
+
+        if (!(d4 & D4_FLIP_ROW)) {
+                for (unsigned row = 0; row < *height; row++) {
+                        read_row(in, buf, rowBytes);
+                        if (flipCol) {
+                                reverse_pixels(buf, *width, bytes);
+                        }
+                        fwrite(buf, 1, rowBytes, out);
+                }
+                FREE(buf);
+                return;
+        }
+
+        /* Rows come out last first: stack them in a temporary file */
+        FILE *stack = tmpfile();
+        assert(stack != NULL);
+        for (unsigned row = 0; row < *height; row++) {
+                read_row(in, buf, rowBytes);
+                if (flipCol) {
+                        reverse_pixels(buf, *width, bytes);
+                }
+                fwrite(buf, 1, rowBytes, stack);
+        }
+        for (unsigned row = *height; row-- > 0; ) {
+                int seeked = fseeko(stack, (off_t)row * rowBytes, SEEK_SET);
+                size_t got = fread(buf, 1, rowBytes, stack);
+                assert(seeked == 0 && got == rowBytes);
+                fwrite(buf, 1, rowBytes, out);
+        }
+        fclose(stack);
+        FREE(buf);
+}
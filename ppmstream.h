@@ -0,0 +1,69 @@
+/*
+ *     ppmstream.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for transforming a raw (P6) ppm as it streams from one file
+ *     to another, without reading the whole image into memory. Only
+ *     transforms that keep rows as rows can be streamed: the identity and
+ *     horizontal flip need one row at a time, while vertical flip and
+ *     rotation by 180 degrees stack the rows in a temporary file and
+ *     unstack them in reverse.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef PPMSTREAM_INCLUDED
+#define PPMSTREAM_INCLUDED
+
+#include <stdio.h>
+#include "d4.h"
+
+/*  Ppmstream_supports
+ *
+ *  Purpose: Tells whether a transform can be streamed
+ *
+ *  Parameters: D4 element of the transform
+ *
+ *  Returns: Nonzero if the element keeps the image's dimensions
+ */
+extern int Ppmstream_supports(int d4);
+
+/*  Ppmstream_raw
+ *
+ *  Purpose: Tells whether a file holds a raw (P6) ppm, without taking
+ *           anything from it, so that a plain (P3) image can still be
+ *           read in full
+ *
+ *  Parameters: file positioned at the start of an image
+ *
+ *  Returns: Nonzero if the file starts with "P6"
+ *
+ *  Errors: checked runtime error if the two bytes read cannot be put
+ *          back
+ */
+extern int Ppmstream_raw(FILE *in);
+
+/*  Ppmstream_transform
+ *
+ *  Purpose: Reads a raw ppm from in and writes its transform to out, one
+ *           row at a time
+ *
+ *  Parameters:
+ *
+ *    in:     file positioned at the start of a P6 image
+ *    out:    file the transformed image is written to
+ *    d4:     D4 element of the transform
+ *    width:  set to the width of the image
+ *    height: set to the height of the image
+ *
+ *  Returns: None
+ *
+ *  Notes: memory use is one row of the image whatever its height
+ *
+ *  Errors: raises Pnm_Badformat if in does not hold a complete P6 image;
+ *          checked runtime error if Ppmstream_supports is false for d4 or
+ *          no temporary file can be made
+ */
+extern void Ppmstream_transform(FILE *in, FILE *out, int d4,
+                                unsigned *width, unsigned *height);
+
+#endif
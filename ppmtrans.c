@@ -4,8 +4,12 @@
  *
  *     This program opens images in ppm format, stores the pixel information
  *     within a 2d array A2Methods, performs a transformation of somesort on
- *     the original image and outputs the result. In addition, this program
- *     uses CPU timing to time each of the relevant transformations before
+ *     the original image and outputs the result. Several transformations
+ *     may be given; they are composed into one and applied in one pass.
+ *     Transformations that only exchange pixels can be done inside the
+ *     array the image was read into, and those that keep rows as rows can
+ *     be streamed a row at a time. In addition, this program uses CPU
+ *     timing to time each of the relevant transformations before
  *     writing the timing information on a seperate output file.
  *
  *     Last Updated: 03/08/2021
@@ -18,12 +22,28 @@
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2morton.h"
 #include "pnm.h"
 #include "cputiming.h"
+#include "perfcount.h"
+#include "timelog.h"
+#include "trace.h"
+#include "d4.h"
+#include "tiletrans.h"
+#include "inplace.h"
+#include "ppmstream.h"
+#include "spectrans.h"
+#include "blocktune.h"
+#include "uarray2b.h"
+#include "ppmio.h"
+#include "alloc.h"
+#include "planar.h"
+#include "sched.h"
 
 #define SET_METHODS(METHODS, MAP, WHAT) do {                    \
         methods = (METHODS);                                    \
         assert(methods != NULL);                                \
+        traversal = WHAT;                                       \
         map = methods->MAP;                                     \
         if (map == NULL) {                                      \
                 fprintf(stderr, "%s does not support "          \
@@ -42,43 +62,114 @@
 static void
 usage(const char *progname)
 {
-        fprintf(stderr, "Usage: %s [[-rotate <angle>] "
-                        "[-flip [vertical | horizontal]] "
-                        "[-transpose]] "
-                        "[-time [filename]] "
-                        "[-{row,col,block}-major] [filename]\n",
+        fprintf(stderr, "Usage: %s [-rotate <angle> | "
+                        "-flip {vertical,horizontal} | "
+                        "-transpose]... "
+                        "[-time filename] [-trace filename] [-threads N] "
+                        "[-in-place] [-stream] "
+                        "[-arena] [-hugepages] [-tune] "
+                        "[-pixels {rgb,packed,padded,planar}] "
+                        "[-{row,col,block,morton}-major] [filename]\n",
                         progname);
         exit(1);
 }
-/* Used for declaring pointers to the relevant transformational functions */
-typedef void transformation(int *col, int *row, int width, int height);
-
-/* Struct used to store pointer to the relevant transformation function and
-    final image */
-typedef struct TypeAndImage {
-        transformation *transformType;
-        Pnm_ppm finalppm;
-} *TypeAndImage;
-
-void perform_transformation(int col, int row, A2Methods_UArray2 array2,
-                            A2Methods_Object *ptr, void *cl);
-void write_time(char *time_file_name, Pnm_ppm ppm, double time, int rotation);
-void setup_rotation(Pnm_ppm origppm, Pnm_ppm finalppm,
-                        TypeAndImage closure, int rotation);
-
-void transform_0(int *col, int *row, int width, int height);
-void transform_90(int *col, int *row, int width, int height);
-void transform_180(int *col, int *row, int width, int height);
-void transform_270(int *col, int *row, int width, int height);
-void transpose(int *col, int *row, int width, int height);
-void horizontal(int *col, int *row, int width, int height);
-void vertical(int *col, int *row, int width, int height);
+/* The phases of a run that -time records, and their names in the record.
+   A phase whose wall time is negative was not timed */
+enum Phase { READ, ALLOCATE, TRANSFORM, WRITE, RELEASE, PHASES };
+static const char *const phaseNames[PHASES] = {
+        "read", "allocate", "transform", "write", "free"
+};
+
+/* A run on a whole image: what was asked for, and the image, held either
+   as one array of pixels or as three planes of one channel each. The
+   engines see only source and dest, one array per plane */
+struct Run {
+        FILE *in;
+        A2Methods_T methods;
+        A2Methods_mapfun *map;          /* order of the kernels if untiled */
+        int d4, tiled, inPlace, nthreads;
+        Ppmio_pixel pixel;
+        Alloc_T arena;                  /* NULL for the heap */
+
+        int planes;
+        A2Methods_UArray2 source[PLANAR_CHANNELS];
+        A2Methods_UArray2 dest[PLANAR_CHANNELS];   /* source, in place */
+
+        Pnm_ppm origppm, finalppm;      /* as pixels */
+        Planar_T origPlanar, finalPlanar;       /* as planes */
+        unsigned denominator;
+};
+
+/* The blocksizes -tune picked, one for each cell size the run's images
+   can have: the 8-bit and the 16-bit size of the pixel format or channel */
+#define TUNED_SIZES 2
+struct Tuning {
+        int n;
+        int sizes[TUNED_SIZES], blocksizes[TUNED_SIZES];
+};
+
+/* How one form of image is read, given a destination, written and freed.
+   read fills in the planes and source, allocate fills in dest */
+struct Form {
+        void (*read)(struct Run *run);
+        void (*allocate)(struct Run *run);
+        void (*write)(struct Run *run);
+        void (*release)(struct Run *run);
+};
+
+void tune(struct Tuning *tuning, int planar, Ppmio_pixel pixel, int d4);
+int tuned_blocksize(int size, void *cl);
+void start_counting(Perfcount_T counters);
+void stop_counting(Perfcount_T counters, struct Perfcount_values *counts);
+void describe_run(Timelog_T log, A2Methods_T methods, const char *traversal,
+                  const char *pixels, int d4, int nthreads);
+void untimed(struct CPUTime_Sample *phases);
+long begin_phase(CPUTime_T timer);
+void end_phase(CPUTime_T timer, struct CPUTime_Sample *phases,
+               enum Phase phase, long span);
+void write_trace(char *trace_file_name);
+void record_resources(Timelog_T log, Sched_T sched, Alloc_T arena);
+void write_time(char *time_file_name, Timelog_T log, long width,
+                long height, struct CPUTime_Sample *phases,
+                struct Perfcount_values *counts);
+void setup_rotation(Pnm_ppm origppm, Pnm_ppm finalppm, int d4,
+                    Alloc_T arena);
+void run_image(struct Run *run, const struct Form *form,
+               char *time_file_name, Timelog_T log, CPUTime_T timer);
+void transform_plane(struct Run *run, int plane, Sched_T sched);
+void read_pixels(struct Run *run);
+void allocate_pixels(struct Run *run);
+void write_pixels(struct Run *run);
+void release_pixels(struct Run *run);
+void read_planes(struct Run *run);
+void allocate_planes(struct Run *run);
+void write_planes(struct Run *run);
+void release_planes(struct Run *run);
+
+static const struct Form pixelForm = {
+        read_pixels, allocate_pixels, write_pixels, release_pixels
+};
+static const struct Form planarForm = {
+        read_planes, allocate_planes, write_planes, release_planes
+};
 
 
 int main(int argc, char *argv[])
 {
         char *time_file_name = NULL;
-        int   rotation       = 0;
+        char *trace_file_name = NULL;
+        int   transform      = D4_ROTATE_0;  /* all transforms so far */
+        int   tiled          = 1;
+        int   nthreads       = 1;
+        int   inPlace        = 0;
+        int   stream         = 0;
+        Ppmio_pixel pixel    = PPMIO_RGB;
+        int   planar         = 0;
+        int   useArena       = 0;
+        int   hugePages      = 0;
+        int   tuneBlocks     = 0;
+        const char *traversal = "default";
+        const char *pixelName = "rgb";
         int   i;
         FILE *filePointer = NULL;
 
@@ -95,18 +186,23 @@ int main(int argc, char *argv[])
                 if (strcmp(argv[i], "-row-major") == 0) {
                         SET_METHODS(uarray2_methods_plain, map_row_major,
                                     "row-major");
+                        tiled = 0;
                 } else if (strcmp(argv[i], "-col-major") == 0) {
                         SET_METHODS(uarray2_methods_plain, map_col_major,
                                     "column-major");
+                        tiled = 0;
                 } else if (strcmp(argv[i], "-block-major") == 0) {
                         SET_METHODS(uarray2_methods_blocked, map_block_major,
                                     "block-major");
+                } else if (strcmp(argv[i], "-morton-major") == 0) {
+                        SET_METHODS(uarray2_methods_morton, map_default,
+                                    "morton-order");
                 } else if (strcmp(argv[i], "-rotate") == 0) {
                         if (!(i + 1 < argc)) {      /* no rotate value */
                                 usage(argv[0]);
                         }
                         char *endptr;
-                        rotation = strtol(argv[++i], &endptr, 10);
+                        int rotation = strtol(argv[++i], &endptr, 10);
                         if (!(rotation == 0 || rotation == 90 ||
                             rotation == 180 || rotation == 270)) {
                                 fprintf(stderr,
@@ -116,20 +212,77 @@ int main(int argc, char *argv[])
                         if (!(*endptr == '\0')) {    /* Not a number */
                                 usage(argv[0]);
                         }
+                        transform = D4_compose(transform,
+                                rotation == 90  ? D4_ROTATE_90  :
+                                rotation == 180 ? D4_ROTATE_180 :
+                                rotation == 270 ? D4_ROTATE_270 :
+                                                  D4_ROTATE_0);
                 } else if (strcmp(argv[i], "-transpose") == 0) {
-                        rotation = 3000;
+                        transform = D4_compose(transform, D4_TRANSPOSE);
                 } else if (strcmp(argv[i], "-flip") == 0) {
+                        if (!(i + 1 < argc)) {      /* no flip type */
+                                usage(argv[0]);
+                        }
                         char *flipType = argv[++i];
                         if (strcmp(flipType, "vertical") == 0) {
-                                rotation = 1000;
+                                transform = D4_compose(transform,
+                                                       D4_FLIP_VERTICAL);
                         } else if (strcmp(flipType, "horizontal") == 0){
-                                rotation = 2000;
+                                transform = D4_compose(transform,
+                                                       D4_FLIP_HORIZONTAL);
                         } else {
                                fprintf(stderr, "Invalid flip type\n");
                                usage(argv[0]);
                         }
+                } else if (strcmp(argv[i], "-threads") == 0) {
+                        if (!(i + 1 < argc)) {      /* no thread count */
+                                usage(argv[0]);
+                        }
+                        char *endptr;
+                        nthreads = strtol(argv[++i], &endptr, 10);
+                        if (*endptr != '\0' || nthreads < 1) {
+                                fprintf(stderr,
+                                        "Thread count must be at least 1\n");
+                                usage(argv[0]);
+                        }
+                } else if (strcmp(argv[i], "-in-place") == 0) {
+                        inPlace = 1;
+                } else if (strcmp(argv[i], "-stream") == 0) {
+                        stream = 1;
+                } else if (strcmp(argv[i], "-arena") == 0) {
+                        useArena = 1;
+                } else if (strcmp(argv[i], "-hugepages") == 0) {
+                        hugePages = 1;
+                } else if (strcmp(argv[i], "-tune") == 0) {
+                        tuneBlocks = 1;
+                } else if (strcmp(argv[i], "-pixels") == 0) {
+                        if (!(i + 1 < argc)) {      /* no pixel format */
+                                usage(argv[0]);
+                        }
+                        char *format = argv[++i];
+                        pixelName = format;
+                        if (strcmp(format, "rgb") == 0) {
+                                pixel = PPMIO_RGB;
+                        } else if (strcmp(format, "packed") == 0) {
+                                pixel = PPMIO_PACKED;
+                        } else if (strcmp(format, "padded") == 0) {
+                                pixel = PPMIO_PADDED;
+                        } else if (strcmp(format, "planar") == 0) {
+                                planar = 1;
+                        } else {
+                                fprintf(stderr, "Invalid pixel format\n");
+                                usage(argv[0]);
+                        }
                 } else if (strcmp(argv[i], "-time") == 0) {
+                        if (!(i + 1 < argc)) {      /* no time file */
+                                usage(argv[0]);
+                        }
                         time_file_name = argv[++i];
+                } else if (strcmp(argv[i], "-trace") == 0) {
+                        if (!(i + 1 < argc)) {      /* no trace file */
+                                usage(argv[0]);
+                        }
+                        trace_file_name = argv[++i];
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n", argv[0],
                                 argv[i]);
@@ -154,240 +307,542 @@ int main(int argc, char *argv[])
                 filePointer = stdin;
         }
 
-        /* Read into ppm */
-        Pnm_ppm origppm = Pnm_ppmread(filePointer, methods);
-
-        /* Setup final ppm */
-        Pnm_ppm finalppm;
-        NEW(finalppm);
-        finalppm->methods = methods;
+        /* -trace records a timeline of the run: its phases, the reading
+           and writing, and every tile and worker thread */
+        if (trace_file_name != NULL) {
+                Trace_enable();
+        }
 
-        /* Define struct which includes a transformation type and final ppm */
-        TypeAndImage closure;
-        NEW(closure);
+        /* -time records each phase of the run, and what ran it, as one
+           line of JSON */
+        Timelog_T log = Timelog_new();
+        describe_run(log, methods, traversal, pixelName, transform,
+                     nthreads);
+        CPUTime_T timer = CPUTime_New();
 
-        /* Setup finalppm dimensions and transformation */
-        setup_rotation(origppm, finalppm, closure, rotation);
+        /* Row-preserving transforms of raw images can go straight from
+           input to output. Reading, transforming and writing are then one
+           phase. Plain images are read in full as usual */
+        if (stream && Ppmstream_supports(transform) &&
+            Ppmstream_raw(filePointer)) {
+                unsigned width, height;
+                struct CPUTime_Sample phases[PHASES];
+                untimed(phases);
+                struct Perfcount_values counts;
+                Perfcount_T counters = time_file_name != NULL ?
+                                       Perfcount_New() : NULL;
+                Timelog_string(log, "engine", "stream");
+                start_counting(counters);
+                long span = begin_phase(timer);
+                Ppmstream_transform(filePointer, stdout, transform,
+                                    &width, &height);
+                end_phase(timer, phases, TRANSFORM, span);
+                stop_counting(counters, &counts);
+                write_time(time_file_name, log, width, height, phases,
+                           &counts);
+                CPUTime_Free(&timer);
+                Timelog_free(&log);
+                if (counters != NULL) {
+                        Perfcount_Free(&counters);
+                }
+                write_trace(trace_file_name);
+                fclose(filePointer);
+                return EXIT_SUCCESS;
+        }
 
-        /* Perform method and calculate time */
-        CPUTime_T timer = CPUTime_New();
-        CPUTime_Start(timer);
-        (*map)(origppm->pixels, perform_transformation, closure);
-        double timeTaken = CPUTime_Stop(timer);
-        write_time(time_file_name, finalppm, timeTaken, rotation);
+        /* With -tune, blocked arrays get the blocksize found fastest for
+           this machine, cell size and transform. The cell size is only
+           known once the header is read, so every size the image could
+           have is tuned now, before any phase is timed */
+        struct Tuning tuning;
+        if (tuneBlocks && methods == uarray2_methods_blocked) {
+                tune(&tuning, planar, pixel, transform);
+                UArray2b_set_default_blocksize(tuned_blocksize, &tuning);
+        }
 
-        /* Write this image */
-        Pnm_ppmwrite(stdout, finalppm);
+        /* With -arena, both images and their bookkeeping come from one
+           arena that is freed in one go at the end. With -hugepages the
+           arena is mapped in 2MB pages, so that stepping down a column
+           of a large image does not miss the TLB every row. Planes always
+           come from the heap */
+        struct Run run;
+        run.in = filePointer;
+        run.methods = methods;
+        run.map = map;
+        run.d4 = transform;
+        run.tiled = tiled;
+        run.inPlace = inPlace;
+        run.nthreads = nthreads;
+        run.pixel = pixel;
+        run.arena = NULL;
+        if (hugePages && !planar) {
+                run.arena = Alloc_arena_new_huge(0);
+        } else if (useArena && !planar) {
+                run.arena = Alloc_arena_new(0);
+        }
 
-        /* Free up all memory */
+        run_image(&run, planar ? &planarForm : &pixelForm, time_file_name,
+                  log, timer);
         CPUTime_Free(&timer);
-        FREE(closure);
-        Pnm_ppmfree(&origppm);
-        Pnm_ppmfree(&finalppm);
+        Timelog_free(&log);
+        write_trace(trace_file_name);
         fclose(filePointer);
 
         return EXIT_SUCCESS;
 }
+
+/* run_image
+      Purpose: Reads the image, gives it a destination unless it can be
+               transformed in place, transforms it plane by plane, writes
+               it and frees it, timing each phase, and appends the timing
+               record
+   Parameters: The run, the form of its image, timing file name (or NULL),
+               record for the timing file, timer for the phases
+      Returns: None
+*/
+void run_image(struct Run *run, const struct Form *form,
+               char *time_file_name, Timelog_T log, CPUTime_T timer)
+{
+        A2Methods_T methods = run->methods;
+        struct CPUTime_Sample phases[PHASES];
+        untimed(phases);
+
+        /* Read the image, timing the input as well */
+        long span = begin_phase(timer);
+        form->read(run);
+        end_phase(timer, phases, READ, span);
+        Timelog_integer(log, "blocksize", methods->blocksize(run->source[0]));
+
+        /* In place, the transformed image is the one that was read */
+        run->inPlace = run->inPlace && Inplace_supports(methods,
+                                                        run->source[0],
+                                                        run->d4);
+        if (run->inPlace) {
+                for (int c = 0; c < run->planes; c++) {
+                        run->dest[c] = run->source[c];
+                }
+        } else {
+                span = begin_phase(timer);
+                form->allocate(run);
+                end_phase(timer, phases, ALLOCATE, span);
+        }
+
+        /* Perform method and calculate time. The counters are opened
+           before the scheduler starts its threads, so that they count
+           those threads too */
+        struct Perfcount_values counts;
+        Perfcount_T counters = time_file_name != NULL ? Perfcount_New()
+                                                      : NULL;
+        Sched_T sched = run->nthreads > 1 ? Sched_shared(run->nthreads)
+                                          : NULL;
+        start_counting(counters);
+        span = begin_phase(timer);
+        for (int c = 0; c < run->planes; c++) {
+                transform_plane(run, c, sched);
+        }
+        end_phase(timer, phases, TRANSFORM, span);
+        stop_counting(counters, &counts);
+        Timelog_string(log, "engine", run->inPlace ? "in-place" :
+                                      run->tiled ? "tiles" : "kernels");
+
+        /* Write this image */
+        span = begin_phase(timer);
+        form->write(run);
+        fflush(stdout);
+        end_phase(timer, phases, WRITE, span);
+        long width = methods->width(run->dest[0]);
+        long height = methods->height(run->dest[0]);
+        record_resources(log, sched, run->arena);
+
+        /* Free up all memory */
+        span = begin_phase(timer);
+        if (counters != NULL) {
+                Perfcount_Free(&counters);
+        }
+        if (sched != NULL) {
+                Sched_free(&sched);
+        }
+        form->release(run);
+        end_phase(timer, phases, RELEASE, span);
+        write_time(time_file_name, log, width, height, phases, &counts);
+}
+
+/* transform_plane
+      Purpose: Transforms one plane of the image. Unless a row or column
+               traversal was asked for, copy tile to tile so that the
+               writes stay local too and the pixel kernels can be used;
+               -row-major and -col-major run the spectrans kernel for that
+               order
+   Parameters: The run, which plane, scheduler to share the work with (or
+               NULL for one thread)
+      Returns: None
+*/
+void transform_plane(struct Run *run, int plane, Sched_T sched)
+{
+        if (run->inPlace) {
+                Inplace_apply(run->methods, run->source[plane], run->d4,
+                              sched);
+        } else if (run->tiled) {
+                Tiletrans_apply(run->methods, run->source[plane],
+                                run->dest[plane], D4_transformation(run->d4),
+                                0, sched);
+        } else {
+                Spectrans_apply(run->methods, run->map, run->source[plane],
+                                run->dest[plane], run->d4, sched);
+        }
+}
+
+/* read_pixels, allocate_pixels, write_pixels, release_pixels
+      Purpose: The form of an image held as one array of whole pixels, in
+               the format -pixels asked for, from the run's arena
+   Parameters: The run
+      Returns: None
+*/
+void read_pixels(struct Run *run)
+{
+        run->origppm = Ppmio_read(run->in, run->methods, run->pixel,
+                                  run->arena);
+        run->planes = 1;
+        run->source[0] = run->origppm->pixels;
+}
+
+void allocate_pixels(struct Run *run)
+{
+        run->finalppm = Alloc_alloc(run->arena, sizeof(*run->finalppm));
+        run->finalppm->methods = run->methods;
+        setup_rotation(run->origppm, run->finalppm, run->d4, run->arena);
+        run->dest[0] = run->finalppm->pixels;
+}
+
+void write_pixels(struct Run *run)
+{
+        /* An image transformed in place may have new dimensions */
+        Pnm_ppm out = run->inPlace ? run->origppm : run->finalppm;
+        out->width = run->methods->width(out->pixels);
+        out->height = run->methods->height(out->pixels);
+        Ppmio_write(stdout, out);
+}
+
+void release_pixels(struct Run *run)
+{
+        if (run->arena != NULL) {
+                Alloc_arena_free(&run->arena);
+                return;
+        }
+        if (!run->inPlace) {
+                Pnm_ppmfree(&run->finalppm);
+        }
+        Pnm_ppmfree(&run->origppm);
+}
+
+/* read_planes, allocate_planes, write_planes, release_planes
+      Purpose: The form of an image held as three planes, one per channel
+               (see planar.h)
+   Parameters: The run
+      Returns: None
+*/
+void read_planes(struct Run *run)
+{
+        run->origPlanar = Ppmio_read_planar(run->in, run->methods,
+                                            &run->denominator);
+        run->planes = PLANAR_CHANNELS;
+        for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                run->source[c] = Planar_plane(run->origPlanar, c);
+        }
+}
+
+void allocate_planes(struct Run *run)
+{
+        int width = Planar_width(run->origPlanar);
+        int height = Planar_height(run->origPlanar);
+        int swaps = D4_swaps_dimensions(run->d4);
+        run->finalPlanar = Planar_new(run->methods, swaps ? height : width,
+                                      swaps ? width : height,
+                                      Planar_channel_size(run->origPlanar));
+        for (int c = 0; c < PLANAR_CHANNELS; c++) {
+                run->dest[c] = Planar_plane(run->finalPlanar, c);
+        }
+}
+
+void write_planes(struct Run *run)
+{
+        Ppmio_write_planar(stdout, run->inPlace ? run->origPlanar
+                                                : run->finalPlanar,
+                           run->denominator);
+}
+
+void release_planes(struct Run *run)
+{
+        if (!run->inPlace) {
+                Planar_free(&run->finalPlanar);
+        }
+        Planar_free(&run->origPlanar);
+}
+
 /* setup_rotation
       Purpose: Set up the required dimensions of the ouput image before
-               transformation occurs, and sets the relevant transform function
-               to the function pointer within the closure struct.
+               transformation occurs, and allocates its pixels
    Parameters: Original untransformed image Pnm_ppm format,
-               Final image Pnm_ppm format, closure storing the transformation
-               type and final image, integer representing the type of
-               transformation to be executed.
+               Final image Pnm_ppm format, D4 element for the composed
+               transformation to be executed, arena for the final image's
+               pixels (or NULL for the heap).
       Returns: None
 */
-void setup_rotation(Pnm_ppm origppm, Pnm_ppm finalppm,
-                        TypeAndImage closure, int rotation)
+void setup_rotation(Pnm_ppm origppm, Pnm_ppm finalppm, int d4,
+                    Alloc_T arena)
 {
-        /* Set appropriate width, height and transformation type */
+        /* Set appropriate width and height */
         finalppm->width = finalppm->methods->width(origppm->pixels);
         finalppm->height = finalppm->methods->height(origppm->pixels);
-        if (rotation == 0) {           /* rotate 0 */
-                closure->transformType = transform_0;
-        } else if (rotation == 90) {   /* rotate 90 */
-                finalppm->width = finalppm->methods->height(origppm->pixels);
-                finalppm->height = finalppm->methods->width(origppm->pixels);
-                closure->transformType = transform_90;
-        } else if (rotation == 180) {  /* rotate 180 */
-                closure->transformType = transform_180;
-        } else if (rotation == 270) {  /* rotate 270 */
-                finalppm->width = finalppm->methods->height(origppm->pixels);
-                finalppm->height = finalppm->methods->width(origppm->pixels);
-                closure->transformType = transform_270;
-        } else if (rotation == 1000) { /* vertical */
-                closure->transformType = vertical;
-        } else if (rotation == 2000) { /* horizontal */
-                closure->transformType = horizontal;
-        } else if (rotation == 3000) { /* transpose */
+        if (D4_swaps_dimensions(d4)) {
                 finalppm->width = finalppm->methods->height(origppm->pixels);
                 finalppm->height = finalppm->methods->width(origppm->pixels);
-                closure->transformType = transpose;
         }
 
-        /* Set total finalppm pixels and store ppm in closure */
+        /* Set total finalppm pixels */
         finalppm->denominator = origppm->denominator;
-        finalppm->pixels = finalppm->methods->new(finalppm->width,
-                                     finalppm->height,
-                                     finalppm->methods->size(origppm->pixels));
-        closure->finalppm = finalppm;
+        finalppm->pixels = finalppm->methods->new_with_allocator(
+                                     finalppm->width, finalppm->height,
+                                     finalppm->methods->size(origppm->pixels),
+                                     0, arena);
 }
 
-/* transform_0
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
+/* describe_run
+      Purpose: Starts a timing record with what the run was asked to do
+   Parameters: The record, methods of the images, name of the traversal,
+               name of the pixel format, D4 element of the transformation,
+               thread count
       Returns: None
 */
-void transform_0(int *col, int *row, int width, int height)
+void describe_run(Timelog_T log, A2Methods_T methods, const char *traversal,
+                  const char *pixels, int d4, int nthreads)
 {
-        (void) col;
-        (void) row;
-        (void) width;
-        (void) height;
+        Timelog_string(log, "layout",
+                       methods == uarray2_methods_plain ? "plain" :
+                       methods == uarray2_methods_blocked ? "blocked" :
+                       methods == uarray2_methods_morton ? "morton" : NULL);
+        Timelog_string(log, "traversal", traversal);
+        Timelog_string(log, "pixels", pixels);
+        Timelog_string(log, "transform", D4_id(d4));
+        Timelog_integer(log, "d4", d4);
+        Timelog_integer(log, "threads", nthreads);
 }
 
-/* transform_90
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
+/* untimed
+      Purpose: Marks every phase of a run as not timed
+   Parameters: Times of the phases
       Returns: None
 */
-void transform_90(int *col, int *row, int width, int height)
+void untimed(struct CPUTime_Sample *phases)
 {
-        (void) width;
-        int newRow = *col;
-        *col = height - *row - 1;
-        *row = newRow;
+        for (int p = 0; p < PHASES; p++) {
+                phases[p].cpu = phases[p].wall = phases[p].thread = -1;
+        }
 }
 
-/* transform_180
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
-      Returns: None
+/* begin_phase
+      Purpose: Starts timing a phase of the run, and its span in the trace
+   Parameters: Timer for the phase
+      Returns: The start of the span (see Trace_begin)
 */
-void transform_180(int *col, int *row, int width, int height)
+long begin_phase(CPUTime_T timer)
 {
-       *col = width - *col - 1;
-        *row = height - *row - 1;
+        long span = Trace_begin();
+        CPUTime_Start(timer);
+        return span;
 }
 
-/* transform_270
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
+/* end_phase
+      Purpose: Stops timing a phase of the run, and records its span
+   Parameters: Timer for the phase, times of the phases, the phase, the
+               start of its span
       Returns: None
 */
-void transform_270(int *col, int *row, int width, int height)
+void end_phase(CPUTime_T timer, struct CPUTime_Sample *phases,
+               enum Phase phase, long span)
 {
-        (void) height;
-        int newRow = width - *col - 1;
-        *col = *row;
-        *row = newRow;
+        CPUTime_Sample(timer, &phases[phase]);
+        Trace_end(phaseNames[phase], span, 0);
 }
 
-/* horizontal
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
+/* write_trace
+      Purpose: Writes the timeline of the run with -trace
+   Parameters: Name of the trace file, or NULL if the run is not traced
       Returns: None
 */
-void horizontal(int *col, int *row, int width, int height){
-        (void) height;
-        (void) row;
-        *col = width - *col - 1;
+void write_trace(char *trace_file_name)
+{
+        if (trace_file_name != NULL && !Trace_write(trace_file_name)) {
+                fprintf(stderr, "Unable to write the trace file %s\n",
+                        trace_file_name);
+        }
 }
 
-/* vertical
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
+/* record_resources
+      Purpose: Adds to a timing record what the pages of the arena turned
+               out to be and how the scheduler's threads shared the work,
+               while the arena and the scheduler still exist
+   Parameters: The record, scheduler that ran the work (NULL if it ran on
+               one thread), arena the images came from (NULL if the heap)
       Returns: None
 */
-void vertical(int *col, int *row, int width, int height){
-        (void) width;
-        int newRow = height - *row - 1;
-        *col = *col;
-        *row = newRow;
-}
+void record_resources(Timelog_T log, Sched_T sched, Alloc_T arena)
+{
+        /* The pages the arena actually got, which may not be the ones
+           -hugepages asked for */
+        if (arena != NULL) {
+                struct Alloc_pages pages = Alloc_pages(arena);
+                Timelog_object(log, "pages");
+                Timelog_integer(log, "hugetlb_bytes", pages.hugetlb);
+                Timelog_integer(log, "advised_bytes", pages.advised);
+                Timelog_integer(log, "advised_huge_bytes",
+                                pages.advisedHuge);
+                Timelog_integer(log, "small_bytes", pages.small);
+                Timelog_close(log);
+        }
 
-/* transpose
-      Purpose: Performs transformation math on the row/col cordinates
-   Parameters: Column value pointer, Row value pointer, width of the array,
-               height of the array
-      Returns: None
-*/
-void transpose(int *col, int *row, int width, int height) {
-        (void) height;
-        (void) width;
-        int newRow = *col;
-        *col = *row;
-        *row = newRow;
+        /* Per-thread share of the work, for tuning the scheduler */
+        if (sched != NULL) {
+                Timelog_array(log, "thread_work");
+                for (int t = 0; t < Sched_threads(sched); t++) {
+                        Timelog_object(log, NULL);
+                        Timelog_integer(log, "tasks",
+                                        Sched_tasks_run(sched, t));
+                        Timelog_integer(log, "steals",
+                                        Sched_steals(sched, t));
+                        Timelog_number(log, "cpu_ns",
+                                       Sched_cpu_time(sched, t));
+                        Timelog_close(log);
+                }
+                Timelog_close(log);
+        }
 }
 
 /* write_time
-      Purpose: Writes the CPU time taken to a file given in the parameter
-   Parameters: Character array of the filename, Image file in ppm type,
-               Total time taken in double format, integer representing the
-               performed transformation
+      Purpose: Finishes a timing record and appends it to the timing file
+               as one line of JSON
+   Parameters: Name of the timing file (NULL if the run is not timed), the
+               record, dimensions of the output image, times of the
+               phases, hardware event counts for the transform
       Returns: None
-        Notes: If character array is empty, function halts with a break command
 */
-void write_time(char *time_file_name, Pnm_ppm ppm, double time, int rotation)
+void write_time(char *time_file_name, Timelog_T log, long width,
+                long height, struct CPUTime_Sample *phases,
+                struct Perfcount_values *counts)
 {
         if (time_file_name == NULL) { return; }
 
-        /* Get statistics */
-        int totalPixelsInImage = ppm->width * ppm->height;
-        double averageTimePerPixel = time / totalPixelsInImage;
-
-        /* Open file and write necessary data */
-        FILE *fp = fopen(time_file_name, "a");
+        long totalPixelsInImage = width * height;
+        Timelog_integer(log, "width", width);
+        Timelog_integer(log, "height", height);
+        Timelog_integer(log, "pixel_count", totalPixelsInImage);
 
-        fprintf(fp, "**************************************************\n");
+        Timelog_object(log, "phases");
+        for (int p = 0; p < PHASES; p++) {
+                if (phases[p].wall >= 0) {
+                        Timelog_sample(log, phaseNames[p], &phases[p]);
+                }
+        }
+        Timelog_close(log);
+
+        /* Per pixel, the CPU time (which with threads is theirs added up),
+           the wall time and any hardware events the machine could count */
+        double pixels = totalPixelsInImage > 0 ? totalPixelsInImage : 1;
+        Timelog_object(log, "transform_per_pixel");
+        Timelog_number(log, "cpu_ns", phases[TRANSFORM].cpu / pixels);
+        Timelog_number(log, "wall_ns", phases[TRANSFORM].wall / pixels);
+        for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+                if (counts->count[e] >= 0) {
+                        Timelog_number(log, Perfcount_Name(e),
+                                       counts->count[e] / pixels);
+                } else {
+                        Timelog_string(log, Perfcount_Name(e), NULL);
+                }
+        }
+        Timelog_close(log);
 
-        if (rotation == 1000) {
-                fprintf(fp, "VERTICAL TRANSFORMATION\n");
-        } else if (rotation == 2000) {
-                fprintf(fp, "HORIZONTAL TRANSFORMATION\n");
-        } else if (rotation == 3000) {
-                fprintf(fp, "TRANSPOSE TRANSFORMATION\n");
-        } else {
-                fprintf(fp, "ROTATION: %d\n", rotation);
+        Timelog_machine(log);
+        if (!Timelog_append(log, time_file_name)) {
+                fprintf(stderr, "Unable to write the timing file %s\n",
+                        time_file_name);
         }
+}
 
-        fprintf(fp, "Total Number of pixels: %d\n", totalPixelsInImage);
-        fprintf(fp, "Total Time Taken:       %f\n", time);
-        fprintf(fp, "Time Taken Per Pixel:   %f\n", averageTimePerPixel);
+/* start_counting
+      Purpose: Starts the hardware event counters, if there are any
+   Parameters: The counters, or NULL when the run is not being timed
+      Returns: None
+*/
+void start_counting(Perfcount_T counters)
+{
+        if (counters != NULL) {
+                Perfcount_Start(counters);
+        }
+}
 
-        fclose(fp);
+/* stop_counting
+      Purpose: Stops the hardware event counters and reads them
+   Parameters: The counters (or NULL, which reads every event as not
+               counted), where to store the counts
+      Returns: None
+*/
+void stop_counting(Perfcount_T counters, struct Perfcount_values *counts)
+{
+        if (counters != NULL) {
+                Perfcount_Stop(counters, counts);
+                return;
+        }
+        for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+                counts->count[e] = -1;
+        }
 }
 
-/* perform_transformation
-      Purpose: Apply function used to write the new row/col cordinates to the
-               output image
-   Parameters: Column value int, row value int, array storing image pixels,
-               Pnm_rgb of the current pixel in the iteration, void pointer to
-               to the struct storing final image & transformation type pointer
+/* tune
+      Purpose: Looks up or times the blocksize for each cell size the
+               image could have, saying so on stderr if the tuning file
+               cannot keep a result and the next run will time it again
+   Parameters: Where to put the blocksizes, whether the image is held as
+               planes, its pixel format otherwise, D4 element to apply
       Returns: None
 */
-void perform_transformation(int col, int row, A2Methods_UArray2 array2,
-                            A2Methods_Object *elem, void *cl)
+void tune(struct Tuning *tuning, int planar, Ppmio_pixel pixel, int d4)
+{
+        int sizes[TUNED_SIZES] = {
+                planar ? 1 : Ppmio_pixel_size(pixel, 255),
+                planar ? 2 : Ppmio_pixel_size(pixel, 65535)
+        };
+        tuning->n = 0;
+        for (int s = 0; s < TUNED_SIZES; s++) {
+                if (s > 0 && sizes[s] == sizes[0]) {
+                        continue;
+                }
+                int kept;
+                tuning->sizes[tuning->n] = sizes[s];
+                tuning->blocksizes[tuning->n] = Blocktune_blocksize(sizes[s],
+                                                                    d4,
+                                                                    &kept);
+                tuning->n++;
+                if (!kept) {
+                        fprintf(stderr, "ppmtrans: cannot write %s; "
+                                "tuned %d-byte cells without keeping the "
+                                "result\n", Blocktune_file(), sizes[s]);
+                }
+        }
+}
+
+/* tuned_blocksize
+      Purpose: Blocksize chooser for -tune
+   Parameters: Size of the cells, the blocksizes tune picked
+      Returns: The blocksize picked for that size, or the 64KB rule for
+               sizes that were not tuned
+*/
+int tuned_blocksize(int size, void *cl)
 {
-        (void) elem;
-        Pnm_rgb origPixel = elem;
-        Pnm_rgb finalPixel;
-        /* Get struct values */
-        TypeAndImage closure = cl;
-        Pnm_ppm finalppm = closure->finalppm;
-        transformation *transform = closure->transformType;
-
-        /* Perform transformation */
-        transform(&col, &row, finalppm->methods->width(array2),
-                               finalppm->methods->height(array2));
-
-        finalPixel = finalppm->methods->at(finalppm->pixels, col, row);
-        *finalPixel = *origPixel;
+        struct Tuning *tuning = cl;
+        for (int s = 0; s < tuning->n; s++) {
+                if (tuning->sizes[s] == size) {
+                        return tuning->blocksizes[s];
+                }
+        }
+        return UArray2b_blocksize_64K(size);
 }
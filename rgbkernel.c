@@ -0,0 +1,295 @@
+/*
+ *     rgbkernel.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the vectorized pixel kernels. Each SIMD kernel first
+ *     splits interleaved pixels into one vector per channel, so that a tile
+ *     transpose becomes three ordinary 32-bit lane transposes and a pixel
+ *     reversal becomes a lane permutation, then merges the channels back.
+ *     The x86 kernels are compiled with per-function target attributes so
+ *     the rest of the program keeps the default instruction set.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdint.h>
+#include <string.h>
+#include "rgbkernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RGBKERNEL_X86 1
+#endif
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *                       Scalar fallback
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+#define SCALAR_TILE 8
+
+static void scalar_transpose(char *const *src, char *const *dst,
+                             int reverseOrder, int reverseEach)
+{
+        for (int i = 0; i < SCALAR_TILE; i++) {
+                char *out = dst[reverseOrder ? SCALAR_TILE - 1 - i : i];
+                for (int j = 0; j < SCALAR_TILE; j++) {
+                        int k = reverseEach ? SCALAR_TILE - 1 - j : j;
+                        memcpy(out + k * RGBKERNEL_PIXEL,
+                               src[j] + i * RGBKERNEL_PIXEL, RGBKERNEL_PIXEL);
+                }
+        }
+}
+
+static void scalar_reverse(const char *src, char *dst)
+{
+        for (int j = 0; j < SCALAR_TILE; j++) {
+                memcpy(dst + (SCALAR_TILE - 1 - j) * RGBKERNEL_PIXEL,
+                       src + j * RGBKERNEL_PIXEL, RGBKERNEL_PIXEL);
+        }
+}
+
+static const struct Rgbkernel_T scalar_kernel = {
+        "scalar", SCALAR_TILE, scalar_transpose, scalar_reverse
+};
+
+#ifdef RGBKERNEL_X86
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *                  SSE2: 4 pixels per 3 registers
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/* [x[i0], x[i1], y[i2], y[i3]] on 32-bit lanes */
+#define SHUF(x, y, i0, i1, i2, i3)                                      \
+        _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(x),            \
+                                        _mm_castsi128_ps(y),            \
+                                        _MM_SHUFFLE(i3, i2, i1, i0)))
+
+/* loads 4 pixels and returns their red, green and blue channels */
+__attribute__((target("sse2")))
+static inline void sse2_split(const char *p, __m128i *r, __m128i *g,
+                              __m128i *b)
+{
+        __m128i a = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_loadu_si128((const __m128i *)(p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(p + 32));
+        *r = SHUF(SHUF(a, a, 0, 0, 3, 3), SHUF(m, c, 2, 2, 1, 1), 0, 2, 0, 2);
+        *g = SHUF(SHUF(a, m, 1, 1, 0, 0), SHUF(m, c, 3, 3, 2, 2), 0, 2, 0, 2);
+        *b = SHUF(SHUF(a, m, 2, 2, 1, 1), SHUF(c, c, 0, 0, 3, 3), 0, 2, 0, 2);
+}
+
+/* inverse of sse2_split */
+__attribute__((target("sse2")))
+static inline void sse2_merge(char *p, __m128i r, __m128i g, __m128i b)
+{
+        __m128i a = SHUF(SHUF(r, g, 0, 0, 0, 0), SHUF(b, r, 0, 0, 1, 1),
+                         0, 2, 0, 2);
+        __m128i m = SHUF(SHUF(g, b, 1, 1, 1, 1), SHUF(r, g, 2, 2, 2, 2),
+                         0, 2, 0, 2);
+        __m128i c = SHUF(SHUF(b, r, 2, 2, 3, 3), SHUF(g, b, 3, 3, 3, 3),
+                         0, 2, 0, 2);
+        _mm_storeu_si128((__m128i *)p, a);
+        _mm_storeu_si128((__m128i *)(p + 16), m);
+        _mm_storeu_si128((__m128i *)(p + 32), c);
+}
+
+/* transposes a 4x4 matrix of 32-bit lanes in place */
+__attribute__((target("sse2")))
+static inline void sse2_transpose4(__m128i *v)
+{
+        __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+        __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+        __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+        __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+        v[0] = _mm_unpacklo_epi64(t0, t1);
+        v[1] = _mm_unpackhi_epi64(t0, t1);
+        v[2] = _mm_unpacklo_epi64(t2, t3);
+        v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+#define SSE2_REVERSE(v) _mm_shuffle_epi32((v), _MM_SHUFFLE(0, 1, 2, 3))
+
+__attribute__((target("sse2")))
+static void sse2_transpose(char *const *src, char *const *dst,
+                           int reverseOrder, int reverseEach)
+{
+        __m128i r[4], g[4], b[4];
+        for (int j = 0; j < 4; j++) {
+                sse2_split(src[j], &r[j], &g[j], &b[j]);
+        }
+        sse2_transpose4(r);
+        sse2_transpose4(g);
+        sse2_transpose4(b);
+        for (int i = 0; i < 4; i++) {
+                char *out = dst[reverseOrder ? 3 - i : i];
+                if (reverseEach) {
+                        sse2_merge(out, SSE2_REVERSE(r[i]),
+                                   SSE2_REVERSE(g[i]), SSE2_REVERSE(b[i]));
+                } else {
+                        sse2_merge(out, r[i], g[i], b[i]);
+                }
+        }
+}
+
+__attribute__((target("sse2")))
+static void sse2_reverse(const char *src, char *dst)
+{
+        __m128i r, g, b;
+        sse2_split(src, &r, &g, &b);
+        sse2_merge(dst, SSE2_REVERSE(r), SSE2_REVERSE(g), SSE2_REVERSE(b));
+}
+
+static const struct Rgbkernel_T sse2_kernel = {
+        "sse2", 4, sse2_transpose, sse2_reverse
+};
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *                  AVX2: 8 pixels per 3 registers
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+/* Lane masks for _mm256_blend_epi32: lanes {0,3,6}, {1,4,7} and {2,5} */
+#define LANES_036 0x49
+#define LANES_147 0x92
+#define LANES_25  0x24
+
+/* loads 8 pixels and returns their red, green and blue channels. Blending
+   the three loads puts each pixel's channel in a distinct lane, and one
+   permutation per channel puts the lanes in pixel order */
+__attribute__((target("avx2")))
+static inline void avx2_split(const char *p, __m256i *r, __m256i *g,
+                              __m256i *b)
+{
+        __m256i a = _mm256_loadu_si256((const __m256i *)p);
+        __m256i m = _mm256_loadu_si256((const __m256i *)(p + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(p + 64));
+        __m256i vr = _mm256_blend_epi32(_mm256_blend_epi32(a, m, LANES_147),
+                                        c, LANES_25);
+        __m256i vg = _mm256_blend_epi32(_mm256_blend_epi32(a, m, LANES_25),
+                                        c, LANES_036);
+        __m256i vb = _mm256_blend_epi32(_mm256_blend_epi32(a, m, LANES_036),
+                                        c, LANES_147);
+        *r = _mm256_permutevar8x32_epi32(vr,
+                        _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+        *g = _mm256_permutevar8x32_epi32(vg,
+                        _mm256_setr_epi32(1, 4, 7, 2, 5, 0, 3, 6));
+        *b = _mm256_permutevar8x32_epi32(vb,
+                        _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+}
+
+/* inverse of avx2_split */
+__attribute__((target("avx2")))
+static inline void avx2_merge(char *p, __m256i r, __m256i g, __m256i b)
+{
+        __m256i pr = _mm256_permutevar8x32_epi32(r,
+                        _mm256_setr_epi32(0, 3, 6, 1, 4, 7, 2, 5));
+        __m256i pg = _mm256_permutevar8x32_epi32(g,
+                        _mm256_setr_epi32(5, 0, 3, 6, 1, 4, 7, 2));
+        __m256i pb = _mm256_permutevar8x32_epi32(b,
+                        _mm256_setr_epi32(2, 5, 0, 3, 6, 1, 4, 7));
+        __m256i a = _mm256_blend_epi32(_mm256_blend_epi32(pr, pg, LANES_147),
+                                       pb, LANES_25);
+        __m256i m = _mm256_blend_epi32(_mm256_blend_epi32(pr, pg, LANES_25),
+                                       pb, LANES_036);
+        __m256i c = _mm256_blend_epi32(_mm256_blend_epi32(pr, pg, LANES_036),
+                                       pb, LANES_147);
+        _mm256_storeu_si256((__m256i *)p, a);
+        _mm256_storeu_si256((__m256i *)(p + 32), m);
+        _mm256_storeu_si256((__m256i *)(p + 64), c);
+}
+
+/* transposes an 8x8 matrix of 32-bit lanes in place */
+__attribute__((target("avx2")))
+static inline void avx2_transpose8(__m256i *v)
+{
+        __m256i t[8], u[8];
+        for (int k = 0; k < 8; k += 2) {
+                t[k] = _mm256_unpacklo_epi32(v[k], v[k + 1]);
+                t[k + 1] = _mm256_unpackhi_epi32(v[k], v[k + 1]);
+        }
+        for (int k = 0; k < 8; k += 4) {
+                u[k] = _mm256_unpacklo_epi64(t[k], t[k + 2]);
+                u[k + 1] = _mm256_unpackhi_epi64(t[k], t[k + 2]);
+                u[k + 2] = _mm256_unpacklo_epi64(t[k + 1], t[k + 3]);
+                u[k + 3] = _mm256_unpackhi_epi64(t[k + 1], t[k + 3]);
+        }
+        for (int k = 0; k < 4; k++) {
+                v[k] = _mm256_permute2x128_si256(u[k], u[k + 4], 0x20);
+                v[k + 4] = _mm256_permute2x128_si256(u[k], u[k + 4], 0x31);
+        }
+}
+
+#define AVX2_REVERSE(v) _mm256_permutevar8x32_epi32((v),                 \
+                        _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0))
+
+__attribute__((target("avx2")))
+static void avx2_transpose(char *const *src, char *const *dst,
+                           int reverseOrder, int reverseEach)
+{
+        __m256i r[8], g[8], b[8];
+        for (int j = 0; j < 8; j++) {
+                avx2_split(src[j], &r[j], &g[j], &b[j]);
+        }
+        avx2_transpose8(r);
+        avx2_transpose8(g);
+        avx2_transpose8(b);
+        for (int i = 0; i < 8; i++) {
+                char *out = dst[reverseOrder ? 7 - i : i];
+                if (reverseEach) {
+                        avx2_merge(out, AVX2_REVERSE(r[i]),
+                                   AVX2_REVERSE(g[i]), AVX2_REVERSE(b[i]));
+                } else {
+                        avx2_merge(out, r[i], g[i], b[i]);
+                }
+        }
+}
+
+__attribute__((target("avx2")))
+static void avx2_reverse(const char *src, char *dst)
+{
+        __m256i r, g, b;
+        avx2_split(src, &r, &g, &b);
+        avx2_merge(dst, AVX2_REVERSE(r), AVX2_REVERSE(g), AVX2_REVERSE(b));
+}
+
+static const struct Rgbkernel_T avx2_kernel = {
+        "avx2", 8, avx2_transpose, avx2_reverse
+};
+
+#endif /* RGBKERNEL_X86 */
+
+/* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *                       Run-time selection
+ * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+
+Rgbkernel_T Rgbkernel_named(const char *name)
+{
+        if (name == NULL) {
+                return NULL;
+        }
+        if (strcmp(name, "scalar") == 0) {
+                return &scalar_kernel;
+        }
+#ifdef RGBKERNEL_X86
+        __builtin_cpu_init();
+        if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+                return &sse2_kernel;
+        }
+        if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+                return &avx2_kernel;
+        }
+#endif
+        return NULL;
+}
+
+Rgbkernel_T Rgbkernel_best(void)
+{
+        static Rgbkernel_T best = NULL;
+        if (best == NULL) {
+                best = Rgbkernel_named("avx2");
+                if (best == NULL) {
+                        best = Rgbkernel_named("sse2");
+                }
+                if (best == NULL) {
+                        best = &scalar_kernel;
+                }
+        }
+        return best;
+}
@@ -0,0 +1,49 @@
+/*
+ *     rgbkernel.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for the vectorized pixel kernels used by the tile engine.
+ *     A kernel moves pixels of three 32-bit channels (the layout of
+ *     struct Pnm_rgb) inside registers: it transposes a small square tile,
+ *     optionally reversing the order of the output rows or the pixels in
+ *     each output row, or it reverses a short run of pixels.
+ *
+ *     Kernels are picked at run time from what the CPU reports through
+ *     CPUID: AVX2 (8x8 tiles), then SSE2 (4x4 tiles), then plain C.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef RGBKERNEL_INCLUDED
+#define RGBKERNEL_INCLUDED
+
+/* Size in bytes of a pixel the kernels can move */
+#define RGBKERNEL_PIXEL 12
+
+typedef const struct Rgbkernel_T *Rgbkernel_T;
+
+struct Rgbkernel_T {
+        const char *name;       /* "avx2", "sse2" or "scalar" */
+        int tile;               /* pixels along one side of a tile */
+
+        /* writes the transpose of the tile whose row j starts at src[j]
+         * into the tile whose row i starts at dst[i], i.e.
+         * dst[i][j] = src[j][i]. If reverseOrder is nonzero, output row i
+         * goes to dst[tile - 1 - i]; if reverseEach is nonzero, the pixels
+         * of every output row are stored in reverse.
+         */
+        void (*transpose)(char *const *src, char *const *dst,
+                          int reverseOrder, int reverseEach);
+
+        /* copies tile pixels from src to dst in reverse order */
+        void (*reverse)(const char *src, char *dst);
+};
+
+/* returns the fastest kernel this CPU supports */
+extern Rgbkernel_T Rgbkernel_best(void);
+
+/* returns the kernel with the given name, or NULL if it is unknown or
+ * this CPU cannot run it
+ */
+extern Rgbkernel_T Rgbkernel_named(const char *name);
+
+#endif
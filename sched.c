@@ -0,0 +1,206 @@
+/*
+ *     sched.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the work-stealing scheduler on top of the worker
+ *     pool. Because every deque starts as a contiguous range of task
+ *     numbers and a thief only ever takes the back half of a range into its
+ *     own empty deque, each deque is always a single range [head, tail)
+ *     guarded by its own lock. No task creates new tasks, so a thread that
+ *     finds every deque empty can stop.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "assert.h"
+#include "mem.h"
+#include "sched.h"
+#include "workers.h"
+#include "trace.h"
+
+#define T Sched_T
+
+/* One thread's deque, padded so that neighbouring deques do not share a
+   cache line */
+struct Deque {
+        pthread_mutex_t lock;
+        int head, tail;
+        int tasksRun, steals;
+        double cpuTime;         /* ns of CPU this thread spent in the job */
+        char pad[64];
+};
+
+struct T {
+        int nthreads;
+        Workers_T workers;
+        struct Deque *deques;
+
+        /* current job */
+        Sched_task *fn;
+        void *cl;
+};
+
+static T shared = NULL;
+
+/*  steal
+ *
+ *  Purpose: Moves the back half of some other thread's deque into this
+ *           thread's (empty) deque
+ *
+ *  Returns: 1 if anything was stolen, 0 if every deque was empty
+ */
+static int steal(T sched, int thread)
+{
+        for (int k = 1; k < sched->nthreads; k++) {
+                struct Deque *victim =
+                        &sched->deques[(thread + k) % sched->nthreads];
+                int lo = 0, hi = 0;
+
+                pthread_mutex_lock(&victim->lock);
+                int remaining = victim->tail - victim->head;
+                if (remaining > 0) {
+                        hi = victim->tail;
+                        lo = hi - (remaining + 1) / 2;
+                        victim->tail = lo;
+                }
+                pthread_mutex_unlock(&victim->lock);
+
+                if (hi > lo) {
+                        struct Deque *own = &sched->deques[thread];
+                        pthread_mutex_lock(&own->lock);
+                        own->head = lo;
+                        own->tail = hi;
+                        own->steals++;
+                        pthread_mutex_unlock(&own->lock);
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+/* Returns the calling thread's CPU time in nanoseconds */
+static double thread_cpu_time(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Body of every worker: drain the own deque, then steal until nothing is
+   left anywhere */
+static void sched_worker(int thread, void *cl)
+{
+        T sched = cl;
+        struct Deque *own = &sched->deques[thread];
+        double start = thread_cpu_time();
+        Trace_name_thread("worker", thread);
+        long span = Trace_begin();
+
+        for (;;) {
+                int task = -1;
+                pthread_mutex_lock(&own->lock);
+                if (own->head < own->tail) {
+                        task = own->head++;
+                }
+                pthread_mutex_unlock(&own->lock);
+
+                if (task >= 0) {
+                        sched->fn(task, thread, sched->cl);
+                        own->tasksRun++;
+                } else if (!steal(sched, thread)) {
+                        own->cpuTime = thread_cpu_time() - start;
+                        Trace_end("work", span, own->tasksRun);
+                        return;
+                }
+        }
+}
+
+T Sched_new(int nthreads)
+{
+        assert(nthreads >= 1);
+        T sched;
+        NEW(sched);
+        sched->nthreads = nthreads;
+        sched->workers = Workers_new(nthreads);
+        sched->deques = CALLOC(nthreads, sizeof(struct Deque));
+        for (int i = 0; i < nthreads; i++) {
+                pthread_mutex_init(&sched->deques[i].lock, NULL);
+        }
+        sched->fn = NULL;
+        sched->cl = NULL;
+        return sched;
+}
+
+void Sched_free(T *sched)
+{
+        assert(sched != NULL && *sched != NULL);
+        T s = *sched;
+        Workers_free(&s->workers);
+        for (int i = 0; i < s->nthreads; i++) {
+                pthread_mutex_destroy(&s->deques[i].lock);
+        }
+        FREE(s->deques);
+        if (shared == s) {
+                shared = NULL;
+        }
+        FREE(s);
+        *sched = NULL;
+}
+
+int Sched_threads(T sched)
+{
+        assert(sched != NULL);
+        return sched->nthreads;
+}
+
+void Sched_run(T sched, int ntasks, Sched_task fn, void *cl)
+{
+        assert(sched != NULL && fn != NULL && ntasks >= 0);
+        sched->fn = fn;
+        sched->cl = cl;
+
+        /* Deal out contiguous shares so that neighbouring tasks, which
+           usually touch neighbouring memory, start on the same thread */
+        for (int i = 0; i < sched->nthreads; i++) {
+                struct Deque *d = &sched->deques[i];
+                Workers_split(ntasks, sched->nthreads, i, &d->head, &d->tail);
+                d->tasksRun = 0;
+                d->steals = 0;
+                d->cpuTime = 0;
+        }
+
+        Workers_run(sched->workers, sched_worker, sched);
+}
+
+int Sched_tasks_run(T sched, int thread)
+{
+        assert(sched != NULL && thread >= 0 && thread < sched->nthreads);
+        return sched->deques[thread].tasksRun;
+}
+
+int Sched_steals(T sched, int thread)
+{
+        assert(sched != NULL && thread >= 0 && thread < sched->nthreads);
+        return sched->deques[thread].steals;
+}
+
+double Sched_cpu_time(T sched, int thread)
+{
+        assert(sched != NULL && thread >= 0 && thread < sched->nthreads);
+        return sched->deques[thread].cpuTime;
+}
+
+T Sched_shared(int nthreads)
+{
+        if (shared != NULL && shared->nthreads != nthreads) {
+                Sched_free(&shared);
+        }
+        if (shared == NULL) {
+                shared = Sched_new(nthreads);
+        }
+        return shared;
+}
+
+#undef T
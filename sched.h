@@ -0,0 +1,60 @@
+/*
+ *     sched.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for a work-stealing scheduler. A job is a count of tasks
+ *     (tiles, bands of rows, ...) numbered from 0. Each thread starts with
+ *     its own deque holding a contiguous share of the task numbers and takes
+ *     tasks from the front; a thread whose deque runs dry steals the back
+ *     half of another thread's deque. Threads that get cheap tasks (partial
+ *     edge tiles, say) therefore end up doing more of them instead of
+ *     idling.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef SCHED_INCLUDED
+#define SCHED_INCLUDED
+
+#define T Sched_T
+typedef struct T *T;
+
+/* runs task number 'task' on worker 'thread' */
+typedef void Sched_task(int task, int thread, void *cl);
+
+/* tasks per thread a job should be cut into so that stealing has
+ * something to balance
+ */
+#define SCHED_TASKS_PER_THREAD 8
+
+/* creates a scheduler with nthreads threads (nthreads < 1 is a checked
+ * run-time error)
+ */
+extern T Sched_new(int nthreads);
+extern void Sched_free(T *sched);
+extern int Sched_threads(T sched);
+
+/* runs fn(task, thread, cl) once for every task in [0, ntasks) and waits
+ * for all of them; calls for different tasks may run concurrently
+ */
+extern void Sched_run(T sched, int ntasks, Sched_task fn, void *cl);
+
+/* statistics from the last Sched_run: tasks run by, and steals made by,
+ * the given thread
+ */
+extern int Sched_tasks_run(T sched, int thread);
+extern int Sched_steals(T sched, int thread);
+
+/* CPU time in nanoseconds the given thread spent on the last Sched_run;
+ * unlike the process's CPU time, it shows whether the threads shared the
+ * work evenly
+ */
+extern double Sched_cpu_time(T sched, int thread);
+
+/* returns a process-wide scheduler of nthreads threads, replacing the
+ * previous one if it was a different size. Not safe to call from several
+ * threads.
+ */
+extern T Sched_shared(int nthreads);
+
+#undef T
+#endif
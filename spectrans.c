@@ -0,0 +1,217 @@
+/*
+ *     spectrans.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the specialized transform kernels. The plain
+ *     layout keeps each row back to back, so if a source cell is at
+ *     base + row * stride + col * size, then a D4 transform sends each
+ *     row (or column) of the source to a line of the destination with a
+ *     constant step between cells. Every kernel is expanded from one macro
+ *     with the traversal, the D4 element and the cell type as constants, so
+ *     that all the index arithmetic folds away even without optimization.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdint.h>
+#include <string.h>
+#include "assert.h"
+#include "spectrans.h"
+#include "a2plain.h"
+#include "d4.h"
+#include "workers.h"
+
+/* Cell types moved by a single load and store. may_alias lets them be
+   used on whatever the cells really hold */
+typedef uint8_t  __attribute__((may_alias)) Cell1;
+typedef uint16_t __attribute__((may_alias)) Cell2;
+typedef struct { uint8_t b[3]; } __attribute__((may_alias)) Cell3;
+typedef uint32_t __attribute__((may_alias)) Cell4;
+typedef struct { uint16_t b[3]; } __attribute__((may_alias)) Cell6;
+typedef uint64_t __attribute__((may_alias)) Cell8;
+typedef struct { uint32_t b[3]; } __attribute__((may_alias)) Cell12;
+
+/* One call: where the arrays are and which outer lines to do */
+struct Job {
+        char *src, *dst;
+        long srcStride, dstStride;      /* bytes per row */
+        int width, height;              /* of the source */
+        int size;
+};
+
+typedef void Kernel(const struct Job *job, int lo, int hi);
+
+/* Destination column and row of source (c, r) under D4 element D */
+#define DEST_COL(D, c, r) ((D) & D4_SWAP ?                              \
+        ((D) & D4_FLIP_COL ? job->height - 1 - (r) : (r)) :             \
+        ((D) & D4_FLIP_COL ? job->width - 1 - (c) : (c)))
+#define DEST_ROW(D, c, r) ((D) & D4_SWAP ?                              \
+        ((D) & D4_FLIP_ROW ? job->width - 1 - (c) : (c)) :              \
+        ((D) & D4_FLIP_ROW ? job->height - 1 - (r) : (r)))
+#define DEST_AT(D, SIZE, c, r) (job->dst + DEST_ROW(D, c, r) *         \
+        job->dstStride + DEST_COL(D, c, r) * (long)(SIZE))
+#define DEST_STEP(D, SIZE, c, r) (                                      \
+        (long)(DEST_ROW(D, c, r) - DEST_ROW(D, 0, 0)) * job->dstStride + \
+        (long)(DEST_COL(D, c, r) - DEST_COL(D, 0, 0)) * (SIZE))
+
+/* Copies one cell: by its type if the size has one, else with memcpy */
+#define COPY_TYPED(TYPE, out, in) (*(TYPE *)(out) = *(const TYPE *)(in))
+#define COPY_BYTES(TYPE, out, in) memcpy(out, in, job->size)
+
+/*  KERNEL
+ *
+ *  Defines kernel_ORDER_NAME_D, which copies source rows (ORDER row) or
+ *  columns (ORDER col) lo to hi - 1 for D4 element D, with cells of SIZE
+ *  bytes moved by COPY as TYPE. A line that stays a forward run in the
+ *  destination is moved with one memcpy.
+ */
+#define KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, D)                  \
+static void kernel_##ORDER##_##NAME##_##D(const struct Job *job, int lo, \
+                                          int hi)                       \
+{                                                                       \
+        int n = ROWS ? job->width : job->height;                        \
+        long inStep = ROWS ? (long)(SIZE) : job->srcStride;             \
+        long outStep = ROWS ? DEST_STEP(D, SIZE, 1, 0)                  \
+                            : DEST_STEP(D, SIZE, 0, 1);                 \
+        for (int line = lo; line < hi; line++) {                        \
+                int c = ROWS ? 0 : line;                                \
+                int r = ROWS ? line : 0;                                \
+                const char *in = job->src + r * job->srcStride +        \
+                                 c * (long)(SIZE);                      \
+                char *out = DEST_AT(D, SIZE, c, r);                     \
+                if (outStep == inStep && inStep == (SIZE)) {            \
+                        memcpy(out, in, (size_t)n * (SIZE));            \
+                        continue;                                       \
+                }                                                       \
+                for (int i = 0; i < n; i++) {                           \
+                        COPY(TYPE, out, in);                            \
+                        in += inStep;                                   \
+                        out += outStep;                                 \
+                }                                                       \
+        }                                                               \
+}
+
+/* The eight kernels for one traversal and cell type */
+#define KERNELS(ORDER, ROWS, NAME, TYPE, SIZE, COPY)                    \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 0)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 1)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 2)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 3)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 4)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 5)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 6)                  \
+        KERNEL(ORDER, ROWS, NAME, TYPE, SIZE, COPY, 7)
+
+/* Every cell type for one traversal; "any" takes its size from the job */
+#define ALL_KERNELS(ORDER, ROWS)                                        \
+        KERNELS(ORDER, ROWS, 1, Cell1, 1, COPY_TYPED)                   \
+        KERNELS(ORDER, ROWS, 2, Cell2, 2, COPY_TYPED)                   \
+        KERNELS(ORDER, ROWS, 3, Cell3, 3, COPY_TYPED)                   \
+        KERNELS(ORDER, ROWS, 4, Cell4, 4, COPY_TYPED)                   \
+        KERNELS(ORDER, ROWS, 6, Cell6, 6, COPY_TYPED)                   \
+        KERNELS(ORDER, ROWS, 8, Cell8, 8, COPY_TYPED)                   \
+        KERNELS(ORDER, ROWS, 12, Cell12, 12, COPY_TYPED)                \
+        KERNELS(ORDER, ROWS, any, char, job->size, COPY_BYTES)
+
+ALL_KERNELS(row, 1)
+ALL_KERNELS(col, 0)
+
+#define ROW_OF(ORDER, NAME) {                                           \
+        kernel_##ORDER##_##NAME##_0, kernel_##ORDER##_##NAME##_1,       \
+        kernel_##ORDER##_##NAME##_2, kernel_##ORDER##_##NAME##_3,       \
+        kernel_##ORDER##_##NAME##_4, kernel_##ORDER##_##NAME##_5,       \
+        kernel_##ORDER##_##NAME##_6, kernel_##ORDER##_##NAME##_7 }
+#define TABLE_OF(ORDER) {                                               \
+        ROW_OF(ORDER, 1), ROW_OF(ORDER, 2), ROW_OF(ORDER, 3),           \
+        ROW_OF(ORDER, 4), ROW_OF(ORDER, 6), ROW_OF(ORDER, 8),           \
+        ROW_OF(ORDER, 12), ROW_OF(ORDER, any) }
+
+/* Cell sizes with kernels of their own, in table order; the last row of
+   each table is for any other size */
+static const int typedSizes[] = { 1, 2, 3, 4, 6, 8, 12 };
+#define SIZE_CLASSES 8
+
+/* kernels[rowMajor][size class][d4] */
+static Kernel *const kernels[2][SIZE_CLASSES][8] = {
+        TABLE_OF(col), TABLE_OF(row)
+};
+
+#undef ROW_OF
+#undef TABLE_OF
+#undef ALL_KERNELS
+#undef KERNELS
+#undef KERNEL
+#undef COPY_BYTES
+#undef COPY_TYPED
+#undef DEST_STEP
+#undef DEST_AT
+#undef DEST_ROW
+#undef DEST_COL
+
+/* Everything a scheduler task needs */
+struct Run {
+        Kernel *kernel;
+        struct Job job;
+        int lines, ntasks;
+};
+
+/* Scheduler task: runs the kernel over one share of the lines */
+static void run_task(int task, int thread, void *cl)
+{
+        struct Run *run = cl;
+        int lo, hi;
+        (void)thread;
+        Workers_split(run->lines, run->ntasks, task, &lo, &hi);
+        run->kernel(&run->job, lo, hi);
+}
+
+int Spectrans_supports(A2Methods_T methods, A2Methods_mapfun *map)
+{
+        return methods == uarray2_methods_plain &&
+               (map == methods->map_row_major ||
+                map == methods->map_col_major);
+}
+
+void Spectrans_apply(A2Methods_T methods, A2Methods_mapfun *map,
+                     A2Methods_UArray2 source, A2Methods_UArray2 dest,
+                     int d4, Sched_T sched)
+{
+        assert(source != NULL && dest != NULL);
+        assert(Spectrans_supports(methods, map));
+        assert(0 <= d4 && d4 < 8);
+
+        struct Run run;
+        struct Job *job = &run.job;
+        job->width = methods->width(source);
+        job->height = methods->height(source);
+        job->size = methods->size(source);
+        assert(job->size == methods->size(dest));
+        assert(methods->width(dest) == (d4 & D4_SWAP ? job->height
+                                                     : job->width));
+        assert(methods->height(dest) == (d4 & D4_SWAP ? job->width
+                                                      : job->height));
+        job->src = methods->at(source, 0, 0);
+        job->dst = methods->at(dest, 0, 0);
+        job->srcStride = (long)job->width * job->size;
+        job->dstStride = (long)methods->width(dest) * job->size;
+        assert(job->height < 2 || (char *)methods->at(source, 0, 1) -
+                                  job->src == job->srcStride);
+
+        int sizeClass = 0;
+        while (sizeClass < SIZE_CLASSES - 1 &&
+               typedSizes[sizeClass] != job->size) {
+                sizeClass++;
+        }
+        int rowMajor = map == methods->map_row_major;
+        run.kernel = kernels[rowMajor][sizeClass][d4];
+        run.lines = rowMajor ? job->height : job->width;
+
+        if (sched == NULL) {
+                run.kernel(job, 0, run.lines);
+                return;
+        }
+        run.ntasks = Sched_threads(sched) * SCHED_TASKS_PER_THREAD;
+        if (run.ntasks > run.lines) {
+                run.ntasks = run.lines;
+        }
+        Sched_run(sched, run.ntasks, run_task, &run);
+}
@@ -0,0 +1,55 @@
+/*
+ *     spectrans.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for the specialized row-major and column-major transform
+ *     kernels. A plain map calls the apply function, the transformation
+ *     and methods->at for every pixel; these kernels are generated once
+ *     for every traversal, D4 element and pixel size, with the
+ *     destination's address stepped by a constant, so the caller picks a
+ *     kernel once and every pixel after that is a load and a store.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef SPECTRANS_INCLUDED
+#define SPECTRANS_INCLUDED
+
+#include "a2methods.h"
+#include "sched.h"
+
+/*  Spectrans_supports
+ *
+ *  Purpose: Says whether there are kernels for a layout and traversal
+ *
+ *  Parameters: methods of the arrays, map giving the traversal
+ *
+ *  Returns: Nonzero for the plain layout's row-major and column-major
+ *           maps, 0 otherwise
+ */
+extern int Spectrans_supports(A2Methods_T methods, A2Methods_mapfun *map);
+
+/*  Spectrans_apply
+ *
+ *  Purpose: Copies every cell of source into dest at the position given by
+ *           D4 element d4, visiting the source in the order of map
+ *
+ *  Parameters:
+ *
+ *    methods: methods for both arrays
+ *    map:     row-major or column-major map of methods
+ *    source:  array holding the untransformed cells
+ *    dest:    array of the transformed dimensions, same element size
+ *    d4:      the transformation, as a D4 element (see d4.h)
+ *    sched:   scheduler whose threads share out the rows or columns, or
+ *             NULL to do all of them on the calling thread
+ *
+ *  Returns: None
+ *
+ *  Errors: checked runtime error if Spectrans_supports(methods, map) is 0
+ *          or the arrays do not match
+ */
+extern void Spectrans_apply(A2Methods_T methods, A2Methods_mapfun *map,
+                            A2Methods_UArray2 source, A2Methods_UArray2 dest,
+                            int d4, Sched_T sched);
+
+#endif
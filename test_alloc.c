@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "alloc.h"
+
+/* Chunk size of the small arenas below */
+#define CHUNK 1024
+
+/* Odd request sizes, none a multiple of ALLOC_ALIGN */
+static const long sizes[] = { 1, 3, 63, 65, 100, 129, 7 };
+#define NSIZES (int)(sizeof(sizes) / sizeof(sizes[0]))
+
+/* Makes the allocations of sizes[] from arena, storing them in ptrs, and
+   checks that each is aligned and that none overlaps the one before */
+static void allocate(Alloc_T arena, char *ptrs[NSIZES])
+{
+    for (int i = 0; i < NSIZES; i++) {
+        ptrs[i] = Alloc_alloc(arena, sizes[i]);
+        assert(ptrs[i] != NULL);
+        assert((uintptr_t)ptrs[i] % ALLOC_ALIGN == 0);
+        memset(ptrs[i], i + 1, sizes[i]);
+        if (i > 0) {
+            assert(ptrs[i] >= ptrs[i - 1] + sizes[i - 1] ||
+                   ptrs[i] + sizes[i] <= ptrs[i - 1]);
+        }
+    }
+    for (int i = 0; i < NSIZES; i++) {
+        for (long b = 0; b < sizes[i]; b++) {
+            assert(ptrs[i][b] == i + 1);
+        }
+    }
+}
+
+/* Bytes of chunks an arena holds */
+static long held(Alloc_T arena)
+{
+    struct Alloc_pages pages = Alloc_pages(arena);
+    return pages.hugetlb + pages.advised + pages.small;
+}
+
+int main () {
+    /* The heap hands out zeroed memory and frees it on release */
+    unsigned char *heap = Alloc_alloc(NULL, 100);
+    for (int i = 0; i < 100; i++) {
+        assert(heap[i] == 0);
+    }
+    Alloc_release(NULL, heap);
+    struct Alloc_pages none = Alloc_pages(NULL);
+    assert(none.hugetlb == 0 && none.advised == 0 && none.small == 0);
+
+    Alloc_T arena = Alloc_arena_new(CHUNK);
+    assert(held(arena) == 0);
+    char *first[NSIZES];
+    allocate(arena, first);
+    long chunks = held(arena);
+    assert(chunks > 0);
+
+    /* A request that does not fit in what is left of the chunk starts a
+       new one, and one larger than a chunk gets a chunk of its own */
+    char *fill = Alloc_alloc(arena, CHUNK - ALLOC_ALIGN);
+    assert(fill + (CHUNK - ALLOC_ALIGN) <= first[0] ||
+           fill >= first[NSIZES - 1] + sizes[NSIZES - 1]);
+    char *big = Alloc_alloc(arena, 5 * CHUNK + 1);
+    assert((uintptr_t)big % ALLOC_ALIGN == 0);
+    memset(big, 0xab, 5 * CHUNK + 1);
+    assert(held(arena) >= chunks + CHUNK + 5 * CHUNK);
+    char *after = Alloc_alloc(arena, 10);
+    assert(after + 10 <= big || after >= big + 5 * CHUNK + 1);
+    long grown = held(arena);
+
+    /* Releasing from an arena gives nothing back; resetting gives it all
+       back and the same allocations land where they did, in the chunks
+       the arena already has */
+    Alloc_release(arena, first[0]);
+    Alloc_arena_reset(arena);
+    char *again[NSIZES];
+    allocate(arena, again);
+    assert(memcmp(again, first, sizeof(first)) == 0);
+    assert(Alloc_alloc(arena, CHUNK - ALLOC_ALIGN) == fill);
+    assert(Alloc_alloc(arena, 5 * CHUNK + 1) == big);
+    assert(held(arena) == grown);
+
+    /* Repeated reset and reuse never grows the arena */
+    for (int round = 0; round < 100; round++) {
+        Alloc_arena_reset(arena);
+        allocate(arena, again);
+        Alloc_alloc(arena, 5 * CHUNK + 1);
+    }
+    assert(held(arena) == grown);
+    Alloc_arena_free(&arena);
+    assert(arena == NULL);
+
+    /* Huge-page arenas align their allocations the same way */
+    Alloc_T huge = Alloc_arena_new_huge(0);
+    char *ptrs[NSIZES];
+    allocate(huge, ptrs);
+    assert(held(huge) >= 2L * 1024 * 1024);
+    Alloc_arena_reset(huge);
+    allocate(huge, ptrs);
+    Alloc_arena_free(&huge);
+
+    printf("alloc ok\n");
+    return EXIT_SUCCESS;
+}
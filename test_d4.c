@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "d4.h"
+
+/* A small non-square image, so that every element is told apart */
+#define WIDTH 5
+#define HEIGHT 3
+#define CELLS (WIDTH * HEIGHT)
+
+/* Moves the width x height image in to its place under d4 in out, and
+   returns the transformed width through *outWidth */
+static void apply(int d4, const int *in, int width, int height, int *out,
+                  int *outWidth)
+{
+    transformation *transform = D4_transformation(d4);
+    *outWidth = D4_swaps_dimensions(d4) ? height : width;
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int c = col, r = row;
+            transform(&c, &r, width, height);
+            out[r * *outWidth + c] = in[row * width + col];
+        }
+    }
+}
+
+int main () {
+    int image[CELLS], once[CELLS], twice[CELLS], composed[CELLS];
+    int w1, w2, wc;
+    for (int i = 0; i < CELLS; i++) {
+        image[i] = i;
+    }
+
+    /* Applying first and then then is the same as applying the
+       composition once */
+    for (int first = 0; first < 8; first++) {
+        for (int then = 0; then < 8; then++) {
+            int d4 = D4_compose(first, then);
+            assert(0 <= d4 && d4 < 8);
+            apply(first, image, WIDTH, HEIGHT, once, &w1);
+            apply(then, once, w1, CELLS / w1, twice, &w2);
+            apply(d4, image, WIDTH, HEIGHT, composed, &wc);
+            assert(w2 == wc);
+            assert(memcmp(twice, composed, sizeof(twice)) == 0);
+        }
+    }
+
+    /* Each element has exactly one inverse, on either side, and undoing
+       it gives the image back */
+    for (int d4 = 0; d4 < 8; d4++) {
+        int inverses = 0;
+        for (int other = 0; other < 8; other++) {
+            if (D4_compose(d4, other) != D4_ROTATE_0) {
+                continue;
+            }
+            inverses++;
+            assert(D4_compose(other, d4) == D4_ROTATE_0);
+            apply(d4, image, WIDTH, HEIGHT, once, &w1);
+            apply(other, once, w1, CELLS / w1, twice, &w2);
+            assert(w2 == WIDTH);
+            assert(memcmp(twice, image, sizeof(image)) == 0);
+        }
+        assert(inverses == 1);
+    }
+
+    /* The identifiers are distinct */
+    for (int a = 0; a < 8; a++) {
+        for (int b = a + 1; b < 8; b++) {
+            assert(strcmp(D4_id(a), D4_id(b)) != 0);
+        }
+    }
+    assert(strcmp(D4_id(D4_ROTATE_90), "rotate-90") == 0);
+    assert(strcmp(D4_id(D4_FLIP_VERTICAL), "flip-vertical") == 0);
+
+    printf("d4 ok\n");
+    return EXIT_SUCCESS;
+}
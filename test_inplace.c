@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "a2morton.h"
+#include "d4.h"
+#include "inplace.h"
+#include "sched.h"
+
+/* Transforms a width x height array of numbered cells in place and checks
+   that every cell ended up where D4_transformation sends it */
+static void check_inplace(A2Methods_T methods, int width, int height,
+                          int d4, Sched_T sched)
+{
+    A2Methods_UArray2 array = methods->new(width, height, sizeof(int));
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            *(int *)methods->at(array, col, row) = row * width + col;
+        }
+    }
+    assert(Inplace_supports(methods, array, d4));
+
+    Inplace_apply(methods, array, d4, sched);
+
+    int swaps = D4_swaps_dimensions(d4);
+    assert(methods->width(array) == (swaps ? height : width));
+    assert(methods->height(array) == (swaps ? width : height));
+    transformation *transform = D4_transformation(d4);
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int c = col, r = row;
+            transform(&c, &r, width, height);
+            assert(*(int *)methods->at(array, c, r) == row * width + col);
+        }
+    }
+    methods->free(&array);
+}
+
+int main () {
+    /* Square sides on and off the tile edge take the four-cycle path for
+       the transforms that swap width and height, the rectangles the
+       cycle-following path and a reshape; the rest swap rows */
+    static const int squares[] = { 1, 2, 31, 32, 33, 70 };
+    static const int rectangles[][2] = {
+        { 1, 9 }, { 9, 1 }, { 13, 7 }, { 7, 13 }, { 64, 3 }, { 50, 77 }
+    };
+    A2Methods_T layouts[] = {
+        uarray2_methods_plain, uarray2_methods_blocked, uarray2_methods_morton
+    };
+    Sched_T sched = Sched_shared(3);
+
+    for (int d4 = 0; d4 < 8; d4++) {
+        for (int s = 0; s < 6; s++) {
+            int n = squares[s];
+            for (int l = 0; l < 3; l++) {
+                check_inplace(layouts[l], n, n, d4, NULL);
+                check_inplace(layouts[l], n, n, d4, sched);
+            }
+        }
+        for (int s = 0; s < 6; s++) {
+            int w = rectangles[s][0], h = rectangles[s][1];
+            check_inplace(uarray2_methods_plain, w, h, d4, NULL);
+            check_inplace(uarray2_methods_plain, w, h, d4, sched);
+            if (!D4_swaps_dimensions(d4)) {
+                check_inplace(uarray2_methods_blocked, w, h, d4, sched);
+                check_inplace(uarray2_methods_morton, w, h, d4, NULL);
+            }
+        }
+    }
+    printf("inplace ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "a2morton.h"
+#include "d4.h"
+#include "planar.h"
+#include "ppmio.h"
+#include "tiletrans.h"
+
+#define WIDTH 13
+#define HEIGHT 7
+#define MAX_RASTER (WIDTH * HEIGHT * 6)
+
+/* Returns a file holding a raw WIDTH x HEIGHT image whose samples all
+   differ, with its raster in raster */
+static FILE *make_image(unsigned denominator, unsigned char *raster)
+{
+    int bytes = denominator > 255 ? 6 : 3;
+    long n = (long)WIDTH * HEIGHT * bytes;
+    for (long i = 0; i < n; i++) {
+        raster[i] = (i * 37 + 11) % 251;
+    }
+    FILE *fp = tmpfile();
+    assert(fp != NULL);
+    fprintf(fp, "P6\n%d %d\n%u\n", WIDTH, HEIGHT, denominator);
+    size_t written = fwrite(raster, 1, n, fp);
+    assert(written == (size_t)n);
+    rewind(fp);
+    return fp;
+}
+
+/* Splits the image into planes, transforms each plane with the tile
+   engine, joins the planes again and checks every pixel against where
+   D4_transformation sends it */
+static void check_round_trip(A2Methods_T methods, unsigned denominator,
+                             int d4)
+{
+    unsigned char raster[MAX_RASTER];
+    FILE *in = make_image(denominator, raster);
+    unsigned readDenominator;
+    Planar_T source = Ppmio_read_planar(in, methods, &readDenominator);
+    fclose(in);
+    assert(readDenominator == denominator);
+    assert(Planar_width(source) == WIDTH && Planar_height(source) == HEIGHT);
+
+    int swaps = D4_swaps_dimensions(d4);
+    int width = swaps ? HEIGHT : WIDTH, height = swaps ? WIDTH : HEIGHT;
+    Planar_T dest = Planar_new(methods, width, height,
+                               Planar_channel_size(source));
+    for (int c = 0; c < PLANAR_CHANNELS; c++) {
+        Tiletrans_apply(methods, Planar_plane(source, c),
+                        Planar_plane(dest, c), D4_transformation(d4), 0,
+                        NULL);
+    }
+
+    FILE *out = tmpfile();
+    assert(out != NULL);
+    Ppmio_write_planar(out, dest, denominator);
+    rewind(out);
+    unsigned w, h, maxval;
+    int fields = fscanf(out, "P6 %u %u %u", &w, &h, &maxval);
+    assert(fields == 3 && (int)w == width && (int)h == height);
+    assert(maxval == denominator && getc(out) == '\n');
+    unsigned char written[MAX_RASTER];
+    int bytes = denominator > 255 ? 6 : 3;
+    size_t got = fread(written, 1, sizeof(written), out);
+    assert(got == (size_t)WIDTH * HEIGHT * bytes);
+    fclose(out);
+
+    transformation *transform = D4_transformation(d4);
+    for (int row = 0; row < HEIGHT; row++) {
+        for (int col = 0; col < WIDTH; col++) {
+            int c = col, r = row;
+            transform(&c, &r, WIDTH, HEIGHT);
+            assert(memcmp(written + ((long)r * width + c) * bytes,
+                          raster + ((long)row * WIDTH + col) * bytes,
+                          bytes) == 0);
+        }
+    }
+    Planar_free(&source);
+    Planar_free(&dest);
+}
+
+int main () {
+    A2Methods_T layouts[] = {
+        uarray2_methods_plain, uarray2_methods_blocked, uarray2_methods_morton
+    };
+    for (int l = 0; l < 3; l++) {
+        for (int d4 = 0; d4 < 8; d4++) {
+            check_round_trip(layouts[l], 255, d4);
+            check_round_trip(layouts[l], 65535, d4);
+        }
+    }
+    printf("planar ok\n");
+    return EXIT_SUCCESS;
+}
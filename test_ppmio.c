@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "except.h"
+#include "a2methods.h"
+#include "a2plain.h"
+#include "pnm.h"
+#include "planar.h"
+#include "ppmio.h"
+
+/* A 2x1 raw image */
+static const char good[] = "P6\n2 1\n255\n\001\002\003\004\005\006";
+
+/* Returns a temporary file holding n bytes of text */
+static FILE *holding(const char *text, size_t n)
+{
+    FILE *fp = tmpfile();
+    assert(fp != NULL);
+    size_t written = fwrite(text, 1, n, fp);
+    assert(written == n);
+    rewind(fp);
+    return fp;
+}
+
+/* Returns nonzero if reading the header, followed by a few bytes of
+   pixels, raises Pnm_Badformat */
+static int rejects(const char *header)
+{
+    char text[128];
+    int n = snprintf(text, sizeof(text), "%s\001\002\003\004\005\006",
+                     header);
+    assert(n > 0 && n < (int)sizeof(text));
+    FILE *fp = holding(text, n);
+    volatile int raised = 0;
+    TRY
+        Pnm_ppm ppm = Ppmio_read(fp, uarray2_methods_plain, PPMIO_PACKED,
+                                 NULL);
+        Pnm_ppmfree(&ppm);
+    EXCEPT(Pnm_Badformat)
+        raised = 1;
+    END_TRY;
+    fclose(fp);
+    return raised;
+}
+
+int main () {
+    /* Sides above INT_MAX, including one that wraps to 1 in 32 bits */
+    assert(rejects("P6\n2147483648 1\n255\n"));
+    assert(rejects("P6\n1 4294967297\n255\n"));
+    assert(rejects("P6\n99999999999999999999 1\n255\n"));
+
+    /* Sides that fit but whose raster would overflow, or just exceed the
+       bytes that follow */
+    assert(rejects("P6\n2147483647 2147483647\n65535\n"));
+    assert(rejects("P6\n2147483647 2147483647\n255\n"));
+    assert(rejects("P6\n1 2\n65535\n"));
+    assert(rejects("P6\n3 1\n255\n"));
+    assert(!rejects("P6\n2 1\n255\n"));
+    assert(!rejects("P6\n1 1\n65535\n"));
+
+    /* Writing to a full device raises rather than losing the image */
+    FILE *in = holding(good, sizeof(good) - 1);
+    Pnm_ppm ppm = Ppmio_read(in, uarray2_methods_plain, PPMIO_RGB, NULL);
+    fclose(in);
+    in = holding(good, sizeof(good) - 1);
+    unsigned denominator;
+    Planar_T planar = Ppmio_read_planar(in, uarray2_methods_plain,
+                                        &denominator);
+    fclose(in);
+
+    FILE *full = fopen("/dev/full", "wb");
+    if (full != NULL) {
+        volatile int raised = 0;
+        TRY
+            Ppmio_write(full, ppm);
+        EXCEPT(Pnm_Badformat)
+            raised = 1;
+        END_TRY;
+        assert(raised);
+        clearerr(full);
+        raised = 0;
+        TRY
+            Ppmio_write_planar(full, planar, denominator);
+        EXCEPT(Pnm_Badformat)
+            raised = 1;
+        END_TRY;
+        assert(raised);
+        fclose(full);
+    }
+
+    /* and writing where there is room still works */
+    FILE *out = tmpfile();
+    assert(out != NULL);
+    Ppmio_write(out, ppm);
+    rewind(out);
+    char buf[64];
+    size_t got = fread(buf, 1, sizeof(buf), out);
+    assert(got == sizeof(good) - 1 && memcmp(buf, good, got) == 0);
+    fclose(out);
+
+    Pnm_ppmfree(&ppm);
+    Planar_free(&planar);
+    printf("ppmio ok\n");
+    return EXIT_SUCCESS;
+}
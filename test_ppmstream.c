@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include "d4.h"
+#include "ppmstream.h"
+
+/* A 2x1 raw image, and the same pixels as a plain image */
+static const char raw[] = "P6\n2 1\n255\n\001\002\003\004\005\006";
+static const char plain[] = "P3\n2 1\n255\n1 2 3 4 5 6\n";
+
+/* Returns a file holding n bytes of text: a temporary file, which can
+   seek, or the read end of a pipe, which cannot */
+static FILE *holding(const char *text, size_t n, int seekable)
+{
+    if (seekable) {
+        FILE *fp = tmpfile();
+        assert(fp != NULL);
+        size_t written = fwrite(text, 1, n, fp);
+        assert(written == n);
+        rewind(fp);
+        return fp;
+    }
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+    ssize_t written = write(fds[1], text, n);
+    assert(written == (ssize_t)n);
+    close(fds[1]);
+    FILE *fp = fdopen(fds[0], "rb");
+    assert(fp != NULL);
+    return fp;
+}
+
+/* Checks that Ppmstream_raw tells the formats apart and leaves every byte
+   of the file to be read, from either kind of file */
+static void check_raw(int seekable)
+{
+    char buf[64];
+
+    FILE *in = holding(plain, strlen(plain), seekable);
+    int isRaw = Ppmstream_raw(in);
+    size_t got = fread(buf, 1, sizeof(buf), in);
+    assert(!isRaw && got == strlen(plain));
+    assert(memcmp(buf, plain, strlen(plain)) == 0);
+    fclose(in);
+
+    in = holding(raw, sizeof(raw) - 1, seekable);
+    isRaw = Ppmstream_raw(in);
+    assert(isRaw);
+    FILE *out = tmpfile();
+    assert(out != NULL);
+    unsigned width, height;
+    Ppmstream_transform(in, out, D4_FLIP_HORIZONTAL, &width, &height);
+    assert(width == 2 && height == 1);
+    rewind(out);
+    const char flipped[] = "P6\n2 1\n255\n\004\005\006\001\002\003";
+    got = fread(buf, 1, sizeof(buf), out);
+    assert(got == sizeof(flipped) - 1);
+    assert(memcmp(buf, flipped, sizeof(flipped) - 1) == 0);
+    fclose(out);
+    fclose(in);
+
+    in = holding("", 0, seekable);
+    isRaw = Ppmstream_raw(in);
+    assert(!isRaw && getc(in) == EOF);
+    fclose(in);
+}
+
+int main () {
+    check_raw(1);
+    check_raw(0);
+    printf("ppmstream ok\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "rgbkernel.h"
+
+#define MAXTILE 8
+
+/* Fills a tile with distinct channel values and checks every kernel this
+   CPU supports against the plain definition of its operation */
+static void check_kernel(Rgbkernel_T kernel)
+{
+    int k = kernel->tile;
+    assert(k <= MAXTILE);
+    uint32_t src[MAXTILE][MAXTILE][3], dst[MAXTILE][MAXTILE][3];
+    char *srcRows[MAXTILE], *dstRows[MAXTILE];
+
+    for (int j = 0; j < k; j++) {
+        for (int i = 0; i < k; i++) {
+            for (int c = 0; c < 3; c++) {
+                src[j][i][c] = 1000000 * c + 1000 * j + i;
+            }
+        }
+        srcRows[j] = (char *)src[j];
+        dstRows[j] = (char *)dst[j];
+    }
+
+    for (int mode = 0; mode < 4; mode++) {
+        int reverseOrder = mode & 1;
+        int reverseEach = mode >> 1;
+        memset(dst, 0, sizeof(dst));
+        kernel->transpose(srcRows, dstRows, reverseOrder, reverseEach);
+        for (int i = 0; i < k; i++) {
+            for (int j = 0; j < k; j++) {
+                int outRow = reverseOrder ? k - 1 - i : i;
+                int outCol = reverseEach ? k - 1 - j : j;
+                assert(memcmp(dst[outRow][outCol], src[j][i], 12) == 0);
+            }
+        }
+    }
+
+    memset(dst, 0, sizeof(dst));
+    kernel->reverse((char *)src[1], (char *)dst[2]);
+    for (int j = 0; j < k; j++) {
+        assert(memcmp(dst[2][k - 1 - j], src[1][j], 12) == 0);
+    }
+}
+
+int main () {
+    const char *names[] = { "scalar", "sse2", "avx2" };
+    for (int n = 0; n < 3; n++) {
+        Rgbkernel_T kernel = Rgbkernel_named(names[n]);
+        if (kernel != NULL) {
+            check_kernel(kernel);
+            printf("%s kernel ok\n", kernel->name);
+        }
+    }
+    assert(Rgbkernel_best() != NULL);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "a2morton.h"
+#include "d4.h"
+#include "tiletrans.h"
+#include "spectrans.h"
+#include "sched.h"
+
+/* Blocksize of the blocked arrays: small, and not a divisor of any side
+   below, so tiles straddle block edges */
+#define BLOCKSIZE 5
+
+/* How a case moves the cells */
+enum Engine { TILES, TILES_THREADED, SPEC_ROW, SPEC_COL, ENGINES };
+
+/* Gives every byte of an array a value that differs from cell to cell */
+static void fill(A2Methods_T methods, A2Methods_UArray2 array2)
+{
+    int size = methods->size(array2);
+    for (int row = 0; row < methods->height(array2); row++) {
+        for (int col = 0; col < methods->width(array2); col++) {
+            unsigned char *cell = methods->at(array2, col, row);
+            for (int b = 0; b < size; b++) {
+                cell[b] = (col * 31 + row * 17 + b * 7 + 1) % 251;
+            }
+        }
+    }
+}
+
+/* Moves a width x height array of size-byte cells with one engine and
+   checks every cell against where D4_transformation sends it */
+static void check_transform(A2Methods_T methods, int width, int height,
+                            int size, int d4, enum Engine engine,
+                            Sched_T sched)
+{
+    int swaps = D4_swaps_dimensions(d4);
+    A2Methods_UArray2 source = methods->new_with_blocksize(width, height,
+                                                           size, BLOCKSIZE);
+    A2Methods_UArray2 dest = methods->new_with_blocksize(
+            swaps ? height : width, swaps ? width : height, size, BLOCKSIZE);
+    fill(methods, source);
+    transformation *transform = D4_transformation(d4);
+
+    switch (engine) {
+    case TILES:
+        Tiletrans_apply(methods, source, dest, transform, 0, NULL);
+        break;
+    case TILES_THREADED:
+        Tiletrans_apply(methods, source, dest, transform, 0, sched);
+        break;
+    case SPEC_ROW:
+        Spectrans_apply(methods, methods->map_row_major, source, dest, d4,
+                        NULL);
+        break;
+    case SPEC_COL:
+        Spectrans_apply(methods, methods->map_col_major, source, dest, d4,
+                        sched);
+        break;
+    default:
+        assert(0);
+    }
+
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < width; col++) {
+            int c = col, r = row;
+            transform(&c, &r, width, height);
+            assert(memcmp(methods->at(dest, c, r),
+                          methods->at(source, col, row), size) == 0);
+        }
+    }
+    methods->free(&source);
+    methods->free(&dest);
+}
+
+int main () {
+    /* 1, 2, 4 and 8 take the integer lanes, 12 the RGB kernels, 3 and 6
+       the typed spectrans kernels and 5 the memcpy fallback. Sides are
+       below, at and off the multiples of the tile and lane sizes */
+    static const int sizes[] = { 1, 2, 3, 4, 5, 6, 8, 12 };
+    static const int shapes[][2] = {
+        { 1, 1 }, { 1, 19 }, { 16, 16 }, { 37, 23 }, { 23, 37 }, { 70, 33 }
+    };
+    A2Methods_T layouts[] = {
+        uarray2_methods_plain, uarray2_methods_blocked, uarray2_methods_morton
+    };
+    Sched_T sched = Sched_shared(3);
+
+    for (int l = 0; l < 3; l++) {
+        for (int s = 0; s < 8; s++) {
+            for (int h = 0; h < 6; h++) {
+                for (int d4 = 0; d4 < 8; d4++) {
+                    for (int e = 0; e < ENGINES; e++) {
+                        if ((e == SPEC_ROW || e == SPEC_COL) &&
+                            !Spectrans_supports(layouts[l],
+                                                layouts[l]->map_row_major)) {
+                            continue;
+                        }
+                        check_transform(layouts[l], shapes[h][0],
+                                        shapes[h][1], sizes[s], d4, e,
+                                        sched);
+                    }
+                }
+            }
+        }
+    }
+    printf("transform ok\n");
+    return EXIT_SUCCESS;
+}
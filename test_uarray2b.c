@@ -1,9 +1,21 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <uarray2b.h>
 #include <assert.h>
 #include <math.h>
 
+/* Checks that block-major mapping visits each cell in address order */
+static void check_order(int col, int row, UArray2b_T array2b, void *elem,
+                        void *cl)
+{
+    char **last = cl;
+    assert(elem == UArray2b_at(array2b, col, row));
+    assert(*last == NULL || (char *)elem > *last);
+    assert(*(int *)elem == col * 1000 + row);
+    *last = elem;
+}
+
 int main () {
     const int width = 10;
     const int height = 10;
@@ -18,6 +30,20 @@ int main () {
     assert(UArray2b_blocksize(uarray2b) == blocksize);
     
     UArray2b_free(&uarray2b);
+
+    /* Partial edge blocks: blocks are contiguous and cache-line aligned */
+    uarray2b = UArray2b_new(13, 7, size, 4);
+    assert((uintptr_t)UArray2b_at(uarray2b, 0, 0) % 64 == 0);
+    assert((char *)UArray2b_at(uarray2b, 4, 0) -
+           (char *)UArray2b_at(uarray2b, 0, 0) == 4 * 4 * size);
+    for (int col = 0; col < 13; col++) {
+        for (int row = 0; row < 7; row++) {
+            *(int *)UArray2b_at(uarray2b, col, row) = col * 1000 + row;
+        }
+    }
+    char *last = NULL;
+    UArray2b_map(uarray2b, check_order, &last);
+    UArray2b_free(&uarray2b);
     
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,417 @@
+/*
+ *     tiletrans.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the tile-to-tile transform engine. Tiles of the
+ *     source are aligned to the array's blocks when it is blocked, so each
+ *     source tile is exactly one block and its image under any rotation or
+ *     transpose lands in at most four destination blocks.
+ *
+ *     For 12-byte RGB cells, each tile is further cut into kernel-sized
+ *     squares (or, for transforms that keep rows as rows, kernel-sized row
+ *     runs) that are moved with the vectorized kernels in rgbkernel.c.
+ *     Cells of 1, 2, 4 or 8 bytes (compact pixels, or the channels of a
+ *     planar image) are cut the same way and moved as integer lanes by
+ *     plain loops the compiler can vectorize. Anything else - ragged tile
+ *     edges, cells of other sizes, or cells that are not contiguous in the
+ *     layout - is copied one cell at a time, but with the destination
+ *     address stepped by a fixed stride within each destination block
+ *     rather than recomputed (with its divisions) for every cell.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <string.h>
+#include <stdint.h>
+#include "assert.h"
+#include "tiletrans.h"
+#include "trace.h"
+#include "rgbkernel.h"
+
+/* Side of the squares, and length of the runs, moved as integer lanes */
+#define LANE_TILE 16
+
+/* The shape of a D4 transform: where source (0, 0) lands, and how the
+   destination moves when the source column or row increases by one */
+struct Shape {
+        int col0, row0;
+        int colStepCol, colStepRow;     /* destination step per source col */
+        int rowStepCol, rowStepRow;     /* destination step per source row */
+};
+
+/* State shared by every tile of one Tiletrans_apply call */
+struct Engine {
+        A2Methods_T methods;
+        A2Methods_UArray2 source, dest;
+        int width, height, size;
+        struct Shape shape;
+        Rgbkernel_T kernel;     /* NULL if the cells are not RGB pixels */
+        int k;                  /* square side for kernels or lanes, or 0 */
+        int tilesize, tileCols;
+};
+
+/*  probe_shape
+ *
+ *  Purpose: Recovers the affine form of a D4 transform by applying it to
+ *           three source positions
+ *
+ *  Parameters: transform function, source width and height
+ *
+ *  Returns: The transform's shape
+ */
+static struct Shape probe_shape(transformation *transform, int width,
+                                int height)
+{
+        struct Shape shape;
+        int col = 0, row = 0;
+        transform(&col, &row, width, height);
+        shape.col0 = col;
+        shape.row0 = row;
+
+        col = 1;
+        row = 0;
+        transform(&col, &row, width, height);
+        shape.colStepCol = col - shape.col0;
+        shape.colStepRow = row - shape.row0;
+
+        col = 0;
+        row = 1;
+        transform(&col, &row, width, height);
+        shape.rowStepCol = col - shape.col0;
+        shape.rowStepRow = row - shape.row0;
+        return shape;
+}
+
+/* Returns nonzero if the n cells from (col, row) rightwards are contiguous
+   in array2, storing the address of the first in *first */
+static inline int run_is_contiguous(struct Engine *e, A2Methods_UArray2 array2,
+                                    int col, int row, int n, char **first)
+{
+        *first = e->methods->at(array2, col, row);
+        char *last = e->methods->at(array2, col + n - 1, row);
+        return last - *first == (long)(n - 1) * e->size;
+}
+
+/*  dest_segment
+ *
+ *  Purpose: Finds how many of the n destination cells from (col, row)
+ *           onwards, stepping by (dcol, drow), stay inside one block of
+ *           the destination, and whether they are evenly spaced there
+ *
+ *  Parameters: engine state; first destination cell; step between cells;
+ *              cells wanted; where to store the spacing in bytes (0 if
+ *              the cells are not evenly spaced)
+ *
+ *  Returns: The number of cells in the segment, at least 1
+ */
+static int dest_segment(struct Engine *e, int col, int row, int dcol,
+                        int drow, int n, long *step)
+{
+        /* Cut at the block boundary the line reaches first */
+        int blocksize = e->methods->blocksize(e->dest);
+        if (blocksize > 1) {
+                int pos = dcol != 0 ? col : row;
+                int forward = dcol + drow > 0;
+                int room = forward ? blocksize - pos % blocksize
+                                   : pos % blocksize + 1;
+                n = n < room ? n : room;
+        }
+
+        *step = 0;
+        if (n > 1) {
+                char *first = e->methods->at(e->dest, col, row);
+                char *second = e->methods->at(e->dest, col + dcol,
+                                              row + drow);
+                char *last = e->methods->at(e->dest, col + (n - 1) * dcol,
+                                            row + (n - 1) * drow);
+                if (last - first == (n - 1) * (second - first)) {
+                        *step = second - first;
+                }
+        }
+        return n;
+}
+
+/*  copy_cells
+ *
+ *  Purpose: Copies the source cells in columns [col0, col1) and rows
+ *           [row0, row1) that the kernels do not move. Each source row is
+ *           cut into segments that stay in one destination block; where
+ *           the layout spaces a segment evenly, its source and destination
+ *           addresses are stepped rather than found with at() per cell.
+ */
+static void copy_cells(struct Engine *e, int col0, int row0, int col1,
+                       int row1)
+{
+        struct Shape *s = &e->shape;
+        for (int row = row0; row < row1; row++) {
+                int col = col0;
+                while (col < col1) {
+                        int destCol = s->col0 + s->colStepCol * col +
+                                      s->rowStepCol * row;
+                        int destRow = s->row0 + s->colStepRow * col +
+                                      s->rowStepRow * row;
+                        long step;
+                        int n = dest_segment(e, destCol, destRow,
+                                             s->colStepCol, s->colStepRow,
+                                             col1 - col, &step);
+                        char *src;
+                        if (step != 0 && run_is_contiguous(e, e->source,
+                                                           col, row, n,
+                                                           &src)) {
+                                char *dst = e->methods->at(e->dest, destCol,
+                                                           destRow);
+                                for (int i = 0; i < n; i++) {
+                                        memcpy(dst, src, e->size);
+                                        dst += step;
+                                        src += e->size;
+                                }
+                        } else {
+                                for (int i = 0; i < n; i++) {
+                                        memcpy(e->methods->at(e->dest,
+                                                destCol + i * s->colStepCol,
+                                                destRow + i * s->colStepRow),
+                                               e->methods->at(e->source,
+                                                              col + i, row),
+                                               e->size);
+                                }
+                        }
+                        col += n;
+                }
+        }
+}
+
+/* Body of lane_transpose for one lane type */
+#define LANE_TRANSPOSE(TYPE) do {                                       \
+        for (int i = 0; i < k; i++) {                                   \
+                TYPE *out = (TYPE *)dst[reverseOrder ? k - 1 - i : i];  \
+                for (int j = 0; j < k; j++) {                           \
+                        out[reverseEach ? k - 1 - j : j] =              \
+                                ((const TYPE *)src[j])[i];              \
+                }                                                       \
+        }                                                               \
+} while (0)
+
+/*  lane_transpose
+ *
+ *  Purpose: The integer-lane counterpart of a kernel's transpose, for k x k
+ *           tiles of cells of 1, 2, 4 or 8 bytes
+ */
+static void lane_transpose(char *const *src, char *const *dst, int k,
+                           int size, int reverseOrder, int reverseEach)
+{
+        switch (size) {
+        case 1: LANE_TRANSPOSE(uint8_t);  break;
+        case 2: LANE_TRANSPOSE(uint16_t); break;
+        case 4: LANE_TRANSPOSE(uint32_t); break;
+        case 8: LANE_TRANSPOSE(uint64_t); break;
+        default: assert(0);
+        }
+}
+#undef LANE_TRANSPOSE
+
+/* Body of lane_reverse for one lane type */
+#define LANE_REVERSE(TYPE) do {                                         \
+        for (int j = 0; j < k; j++) {                                   \
+                ((TYPE *)dst)[k - 1 - j] = ((const TYPE *)src)[j];      \
+        }                                                               \
+} while (0)
+
+/* Copies k cells of 1, 2, 4 or 8 bytes from src to dst in reverse order */
+static void lane_reverse(const char *src, char *dst, int k, int size)
+{
+        switch (size) {
+        case 1: LANE_REVERSE(uint8_t);  break;
+        case 2: LANE_REVERSE(uint16_t); break;
+        case 4: LANE_REVERSE(uint32_t); break;
+        case 8: LANE_REVERSE(uint64_t); break;
+        default: assert(0);
+        }
+}
+#undef LANE_REVERSE
+
+/*  copy_square
+ *
+ *  Purpose: Moves the k x k source square at (col0, row0) with one kernel
+ *           (or lane) transpose, for transforms that turn source columns
+ *           into destination rows
+ *
+ *  Returns: 1 if the kernel was used, 0 if the cells were not contiguous
+ */
+static int copy_square(struct Engine *e, int col0, int row0)
+{
+        int k = e->k;
+        struct Shape *s = &e->shape;
+        char *src[k], *dst[k];
+
+        /* Destination tile corner: smallest row and column it covers */
+        int destCol = s->col0 + s->rowStepCol * (s->rowStepCol > 0 ? row0
+                                                 : row0 + k - 1);
+        int destRow = s->row0 + s->colStepRow * (s->colStepRow > 0 ? col0
+                                                 : col0 + k - 1);
+        for (int j = 0; j < k; j++) {
+                if (!run_is_contiguous(e, e->source, col0, row0 + j, k,
+                                       &src[j]) ||
+                    !run_is_contiguous(e, e->dest, destCol, destRow + j, k,
+                                       &dst[j])) {
+                        return 0;
+                }
+        }
+        if (e->kernel != NULL) {
+                e->kernel->transpose(src, dst, s->colStepRow < 0,
+                                     s->rowStepCol < 0);
+        } else {
+                lane_transpose(src, dst, k, e->size, s->colStepRow < 0,
+                               s->rowStepCol < 0);
+        }
+        return 1;
+}
+
+/*  copy_run
+ *
+ *  Purpose: Moves k source cells from (col0, row) rightwards, for
+ *           transforms that keep source rows as destination rows
+ *
+ *  Returns: 1 if the run was moved in bulk, 0 if the cells were not
+ *           contiguous
+ */
+static int copy_run(struct Engine *e, int col0, int row)
+{
+        int k = e->k;
+        char *src, *dst;
+        int reversed = e->shape.colStepCol < 0;
+        int first = reversed ? col0 + k - 1 : col0;
+        struct Shape *s = &e->shape;
+        int destCol = s->col0 + s->colStepCol * first;
+        int destRow = s->row0 + s->rowStepRow * row;
+
+        if (!run_is_contiguous(e, e->source, col0, row, k, &src) ||
+            !run_is_contiguous(e, e->dest, destCol, destRow, k, &dst)) {
+                return 0;
+        }
+        if (reversed && e->kernel != NULL) {
+                e->kernel->reverse(src, dst);
+        } else if (reversed) {
+                lane_reverse(src, dst, k, e->size);
+        } else {
+                memcpy(dst, src, (size_t)k * e->size);
+        }
+        return 1;
+}
+
+/*  copy_tile
+ *
+ *  Purpose: Copies the source cells in columns [col0, col1) and rows
+ *           [row0, row1) to their transformed positions in dest
+ *
+ *  Parameters: engine state; tile bounds
+ *
+ *  Returns: None
+ */
+static void copy_tile(struct Engine *e, int col0, int row0, int col1,
+                      int row1)
+{
+        if (e->k == 0) {
+                copy_cells(e, col0, row0, col1, row1);
+                return;
+        }
+
+        int k = e->k;
+        int swaps = e->shape.colStepCol == 0;
+
+        if (swaps) {
+                /* Whole k x k squares, then the ragged right and bottom */
+                int rowEnd = row0 + (row1 - row0) / k * k;
+                int colEnd = col0 + (col1 - col0) / k * k;
+                for (int row = row0; row < rowEnd; row += k) {
+                        for (int col = col0; col < colEnd; col += k) {
+                                if (!copy_square(e, col, row)) {
+                                        copy_cells(e, col, row, col + k,
+                                                   row + k);
+                                }
+                        }
+                        copy_cells(e, colEnd, row, col1, row + k);
+                }
+                copy_cells(e, col0, rowEnd, col1, row1);
+        } else {
+                int colEnd = col0 + (col1 - col0) / k * k;
+                for (int row = row0; row < row1; row++) {
+                        for (int col = col0; col < colEnd; col += k) {
+                                if (!copy_run(e, col, row)) {
+                                        copy_cells(e, col, row, col + k,
+                                                   row + 1);
+                                }
+                        }
+                        copy_cells(e, colEnd, row, col1, row + 1);
+                }
+        }
+}
+
+/*  tile_task
+ *
+ *  Purpose: Scheduler task; copies tile number 'task', counting tiles
+ *           row-major across the source so that neighbouring task numbers
+ *           are neighbouring tiles
+ *
+ *  Parameters: tile number, thread running it, engine state
+ *
+ *  Returns: None
+ */
+static void tile_task(int task, int thread, void *cl)
+{
+        struct Engine *e = cl;
+        (void)thread;
+        int row0 = task / e->tileCols * e->tilesize;
+        int col0 = task % e->tileCols * e->tilesize;
+        int row1 = row0 + e->tilesize < e->height ? row0 + e->tilesize
+                                                  : e->height;
+        int col1 = col0 + e->tilesize < e->width ? col0 + e->tilesize
+                                                 : e->width;
+        long span = Trace_begin();
+        copy_tile(e, col0, row0, col1, row1);
+        Trace_end("tile", span, task);
+}
+
+void Tiletrans_apply(A2Methods_T methods, A2Methods_UArray2 source,
+                     A2Methods_UArray2 dest, transformation *transform,
+                     int tilesize, Sched_T sched)
+{
+        assert(methods != NULL && source != NULL && dest != NULL);
+        assert(transform != NULL && tilesize >= 0);
+
+        struct Engine e;
+        e.methods = methods;
+        e.source = source;
+        e.dest = dest;
+        e.width = methods->width(source);
+        e.height = methods->height(source);
+        e.size = methods->size(source);
+        assert(e.size == methods->size(dest));
+        e.shape = probe_shape(transform, e.width, e.height);
+        e.kernel = e.size == RGBKERNEL_PIXEL ? Rgbkernel_best() : NULL;
+        if (e.kernel != NULL) {
+                e.k = e.kernel->tile;
+        } else if (e.size == 1 || e.size == 2 || e.size == 4 ||
+                   e.size == 8) {
+                e.k = LANE_TILE;
+        } else {
+                e.k = 0;
+        }
+
+        if (tilesize == 0) {
+                tilesize = methods->blocksize(source);
+                if (tilesize <= 1) {
+                        tilesize = TILETRANS_DEFAULT_TILE;
+                }
+        }
+
+        e.tilesize = tilesize;
+        e.tileCols = (e.width + tilesize - 1) / tilesize;
+        int tiles = e.tileCols * ((e.height + tilesize - 1) / tilesize);
+
+        if (sched == NULL) {
+                for (int task = 0; task < tiles; task++) {
+                        tile_task(task, 0, &e);
+                }
+        } else {
+                Sched_run(sched, tiles, tile_task, &e);
+        }
+}
@@ -0,0 +1,54 @@
+/*
+ *     tiletrans.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for the tile-to-tile transform engine. Rather than mapping
+ *     over the source one pixel at a time and scattering writes across the
+ *     destination, the engine copies one square tile of the source into the
+ *     matching tile of the destination before moving on, so the reads and
+ *     the writes both stay inside a cache-resident pair of tiles.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef TILETRANS_INCLUDED
+#define TILETRANS_INCLUDED
+
+#include "a2methods.h"
+#include "d4.h"
+#include "sched.h"
+
+/* Tile side used when the array is not blocked */
+#define TILETRANS_DEFAULT_TILE 32
+
+/*  Tiletrans_apply
+ *
+ *  Purpose: Copies every cell of source into dest at the position given by
+ *           transform, one tile at a time
+ *
+ *  Parameters:
+ *
+ *    methods:   methods for both arrays (they must share a layout)
+ *    source:    array holding the untransformed cells
+ *    dest:      array of the transformed dimensions, same element size
+ *    transform: function mapping source to destination coordinates; must
+ *               be one of the eight rotations/reflections of the grid
+ *    tilesize:  cells along one side of a tile; 0 picks the array's
+ *               blocksize if it is blocked, else TILETRANS_DEFAULT_TILE
+ *    sched:     scheduler whose threads share out the tiles, or NULL to
+ *               copy every tile on the calling thread
+ *
+ *  Returns: None
+ *
+ *  Notes: cells of 12 bytes are taken to be RGB pixels and moved with the
+ *         vectorized kernels in rgbkernel.h where the layout allows; cells
+ *         of 1, 2, 4 or 8 bytes are moved a square of integer lanes at a
+ *         time
+ *
+ *  Errors: checked runtime error if the element sizes differ or tilesize is
+ *          negative
+ */
+extern void Tiletrans_apply(A2Methods_T methods, A2Methods_UArray2 source,
+                            A2Methods_UArray2 dest, transformation *transform,
+                            int tilesize, Sched_T sched);
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ *     timelog.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of timing records. The JSON text is built in a
+ *     growing buffer; a stack remembers, for each object or array open,
+ *     whether it is an array and whether it has a field yet (so whether
+ *     the next one needs a comma).
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "assert.h"
+#include "mem.h"
+#include "timelog.h"
+
+#define T Timelog_T
+
+/* Deepest nesting of objects and arrays */
+#define MAX_DEPTH 16
+
+struct T {
+        char *text;
+        int length, capacity;
+        int depth;                      /* 1 for the record itself */
+        char isArray[MAX_DEPTH];
+        char hasField[MAX_DEPTH];
+};
+
+/*  append
+ *
+ *  Purpose: Adds printf-formatted text to the record, growing the buffer
+ *           as needed
+ */
+static void append(T log, const char *format, ...)
+{
+        for (;;) {
+                va_list args;
+                va_start(args, format);
+                int room = log->capacity - log->length;
+                int n = vsnprintf(log->text + log->length, room, format,
+                                  args);
+                va_end(args);
+                assert(n >= 0);
+                if (n < room) {
+                        log->length += n;
+                        return;
+                }
+                log->capacity = 2 * log->capacity + n;
+                RESIZE(log->text, log->capacity);
+        }
+}
+
+/*  append_string
+ *
+ *  Purpose: Adds a string as a quoted JSON string, or null
+ */
+static void append_string(T log, const char *s)
+{
+        if (s == NULL) {
+                append(log, "null");
+                return;
+        }
+        append(log, "\"");
+        for (; *s != '\0'; s++) {
+                unsigned char c = *s;
+                if (c == '"' || c == '\\') {
+                        append(log, "\\%c", c);
+                } else if (c < 0x20) {
+                        append(log, "\\u%04x", c);
+                } else {
+                        append(log, "%c", c);
+                }
+        }
+        append(log, "\"");
+}
+
+/*  start_field
+ *
+ *  Purpose: Writes what goes before a value: a comma if the enclosing
+ *           object or array has a field already, and the key in an object
+ */
+static void start_field(T log, const char *key)
+{
+        assert(log != NULL && log->depth > 0);
+        int top = log->depth - 1;
+        assert((key == NULL) == log->isArray[top]);
+        if (log->hasField[top]) {
+                append(log, ", ");
+        }
+        log->hasField[top] = 1;
+        if (key != NULL) {
+                append_string(log, key);
+                append(log, ": ");
+        }
+}
+
+/* Opens an object ('{') or an array ('[') after its key is written */
+static void open_nested(T log, char bracket)
+{
+        assert(log->depth < MAX_DEPTH);
+        append(log, "%c", bracket);
+        log->isArray[log->depth] = bracket == '[';
+        log->hasField[log->depth] = 0;
+        log->depth++;
+}
+
+T Timelog_new(void)
+{
+        T log;
+        NEW(log);
+        log->capacity = 256;
+        log->text = ALLOC(log->capacity);
+        log->length = 0;
+        log->depth = 0;
+        open_nested(log, '{');
+        return log;
+}
+
+void Timelog_free(T *log)
+{
+        assert(log != NULL && *log != NULL);
+        FREE((*log)->text);
+        FREE(*log);
+}
+
+void Timelog_string(T log, const char *key, const char *value)
+{
+        start_field(log, key);
+        append_string(log, value);
+}
+
+void Timelog_integer(T log, const char *key, long value)
+{
+        start_field(log, key);
+        append(log, "%ld", value);
+}
+
+void Timelog_number(T log, const char *key, double value)
+{
+        start_field(log, key);
+        append(log, "%.3f", value);
+}
+
+void Timelog_object(T log, const char *key)
+{
+        start_field(log, key);
+        open_nested(log, '{');
+}
+
+void Timelog_array(T log, const char *key)
+{
+        start_field(log, key);
+        open_nested(log, '[');
+}
+
+void Timelog_close(T log)
+{
+        assert(log != NULL && log->depth > 1);
+        log->depth--;
+        append(log, "%c", log->isArray[log->depth] ? ']' : '}');
+}
+
+void Timelog_sample(T log, const char *key, struct CPUTime_Sample *sample)
+{
+        assert(sample != NULL);
+        Timelog_object(log, key);
+        Timelog_number(log, "cpu_ns", sample->cpu);
+        Timelog_number(log, "wall_ns", sample->wall);
+        Timelog_number(log, "thread_ns", sample->thread);
+        Timelog_close(log);
+}
+
+/*  cpu_model
+ *
+ *  Purpose: Reads the first "model name" line of /proc/cpuinfo
+ *
+ *  Returns: 1 with the name in buf, or 0 if there is none
+ */
+static int cpu_model(char *buf, int len)
+{
+        FILE *fp = fopen("/proc/cpuinfo", "r");
+        if (fp == NULL) {
+                return 0;
+        }
+        char line[512];
+        int found = 0;
+        while (!found && fgets(line, sizeof(line), fp) != NULL) {
+                char *colon = strchr(line, ':');
+                if (strncmp(line, "model name", 10) != 0 || colon == NULL) {
+                        continue;
+                }
+                colon += strspn(colon + 1, " \t") + 1;
+                colon[strcspn(colon, "\n")] = '\0';
+                snprintf(buf, len, "%s", colon);
+                found = 1;
+        }
+        fclose(fp);
+        return found;
+}
+
+void Timelog_machine(T log)
+{
+        char host[256], model[256];
+        if (gethostname(host, sizeof(host)) != 0) {
+                host[0] = '\0';
+        }
+        host[sizeof(host) - 1] = '\0';
+        Timelog_string(log, "host", host);
+        Timelog_string(log, "cpu", cpu_model(model, sizeof(model)) ? model
+                                                                   : NULL);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        Timelog_integer(log, "peak_rss_kb", usage.ru_maxrss);
+}
+
+int Timelog_append(T log, const char *filename)
+{
+        assert(log != NULL && filename != NULL);
+        while (log->depth > 1) {
+                Timelog_close(log);
+        }
+        FILE *fp = fopen(filename, "a");
+        if (fp == NULL) {
+                return 0;
+        }
+        int ok = fprintf(fp, "%.*s}\n", log->length, log->text) > 0;
+        ok = fclose(fp) == 0 && ok;
+        return ok;
+}
+
+#undef T
@@ -0,0 +1,57 @@
+/*
+ *     timelog.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for building the records ppmtrans -time writes. A record
+ *     is one JSON object, built up a field at a time (with nested objects
+ *     and arrays), and appended to a file as a single line, so that a
+ *     timing file is "JSON lines": one run per line, ready for tools that
+ *     ingest it without scraping.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef TIMELOG_INCLUDED
+#define TIMELOG_INCLUDED
+
+#include "cputiming.h"
+
+#define T Timelog_T
+typedef struct T *T;
+
+/* creates an empty record */
+extern T Timelog_new(void);
+extern void Timelog_free(T *log);
+
+/* Fields. key names the field inside an object and must be NULL inside an
+ * array (anything else is a checked run-time error). Strings are escaped
+ * as JSON needs; a NULL value is written as null.
+ */
+extern void Timelog_string(T log, const char *key, const char *value);
+extern void Timelog_integer(T log, const char *key, long value);
+extern void Timelog_number(T log, const char *key, double value);
+
+/* opens a nested object or array, which later fields go into until the
+ * matching Timelog_close
+ */
+extern void Timelog_object(T log, const char *key);
+extern void Timelog_array(T log, const char *key);
+extern void Timelog_close(T log);
+
+/* adds an object holding a sample's cpu_ns, wall_ns and thread_ns */
+extern void Timelog_sample(T log, const char *key,
+                           struct CPUTime_Sample *sample);
+
+/* adds host (the host name), cpu (the model name from /proc/cpuinfo, or
+ * null) and peak_rss_kb (the largest resident set this process has had)
+ */
+extern void Timelog_machine(T log);
+
+/* closes any objects or arrays left open and appends the record to the
+ * named file as one line
+ *
+ * returns 1 on success, 0 if the file could not be written
+ */
+extern int Timelog_append(T log, const char *filename);
+
+#undef T
+#endif
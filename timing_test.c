@@ -1,7 +1,32 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include "cputiming.h"
+#include "perfcount.h"
 
+/* Work for CPUTime_Repeat: sums the first *cl integers */
+static void
+sum_loop(void *cl)
+{
+	int limit = *(int *)cl;
+	volatile double sum = 0.0;
+	for (int i = 0; i < limit; i++) {
+		sum += i;
+	}
+}
+
+/* Prints a summary of one clock; returns 0 if it is inconsistent */
+static int
+print_stats(const char *clock, struct CPUTime_Stats *stats)
+{
+	printf("%-6s kept %d of %d: min %.0f median %.0f p95 %.0f "
+	       "mean %.0f stddev %.0f\n", clock, stats->kept, stats->runs,
+	       stats->min, stats->median, stats->p95, stats->mean,
+	       stats->stddev);
+	return 1 <= stats->kept && stats->kept <= stats->runs &&
+	       stats->min <= stats->median && stats->median <= stats->p95 &&
+	       stats->stddev >= 0;
+}
 
 int
 main(int argc, char *argv[])
@@ -30,8 +55,73 @@ main(int argc, char *argv[])
 		innerlimit *= 10;
 	}
 
+	/* Every clock at once, over the largest loop again */
+	struct CPUTime_Sample sample;
+	innerlimit /= 10;
+	CPUTime_Start(timer);
+	sum_loop(&innerlimit);
+	CPUTime_Sample(timer, &sample);
+	printf("Loop of %d took %.0f ns CPU, %.0f ns wall, %.0f ns thread\n",
+	       innerlimit, sample.cpu, sample.wall, sample.thread);
+	if (sample.cpu <= 0 || sample.wall <= 0 || sample.thread <= 0) {
+		return EXIT_FAILURE;
+	}
+
+	/* A known set of samples: 1000 is an outlier and is rejected */
+	const double known[] = { 12, 10, 1000, 13, 11 };
+	struct CPUTime_Stats stats;
+	CPUTime_Summarize(known, 5, &stats);
+	if (!print_stats("known", &stats) || stats.kept != 4 ||
+	    stats.min != 10 || stats.median != 11.5 || stats.p95 != 13 ||
+	    stats.mean != 11.5 || fabs(stats.stddev - sqrt(5.0 / 3)) > 1e-9) {
+		return EXIT_FAILURE;
+	}
+
+	/* Equal samples have no spread, so none can be rejected */
+	const double equal[] = { 7, 7, 7, 7, 7, 9 };
+	CPUTime_Summarize(equal, 6, &stats);
+	if (!print_stats("equal", &stats) || stats.kept != 6) {
+		return EXIT_FAILURE;
+	}
+
+	/* Repeated runs of a smaller loop */
+	struct CPUTime_Repeated repeated;
+	int limit = 100000;
+	CPUTime_Repeat(timer, 2, 15, sum_loop, &limit, &repeated);
+	if (!print_stats("cpu", &repeated.cpu) ||
+	    !print_stats("wall", &repeated.wall) ||
+	    !print_stats("thread", &repeated.thread) ||
+	    repeated.wall.runs != 15) {
+		return EXIT_FAILURE;
+	}
+
 	CPUTime_Free(&timer);
 
+	/* Count hardware events over the last loop again, where the
+	   machine lets us; otherwise every count must read as missing */
+	Perfcount_T counters = Perfcount_New();
+	struct Perfcount_values counts;
+	sum = 0.0;
+	Perfcount_Start(counters);
+	for (i = 0; i < innerlimit; i++) {
+		sum += i;
+	}
+	Perfcount_Stop(counters, &counts);
+	printf("Sum %.0f counted with %d of %d events:", sum,
+	       Perfcount_Available(counters), PERFCOUNT_EVENTS);
+	for (int e = 0; e < PERFCOUNT_EVENTS; e++) {
+		if (Perfcount_Available(counters) == 0 && counts.count[e] >= 0) {
+			return EXIT_FAILURE;
+		}
+		if (counts.count[e] < 0) {
+			printf(" n/a %s", Perfcount_Name(e));
+		} else {
+			printf(" %.0f %s", counts.count[e], Perfcount_Name(e));
+		}
+	}
+	printf("\n");
+	Perfcount_Free(&counters);
+
 	return EXIT_SUCCESS;
 }
 
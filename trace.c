@@ -0,0 +1,165 @@
+/*
+ *     trace.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the trace recorder. A thread's ring is made the
+ *     first time it records a span and put on a list of every ring, the
+ *     only step that takes a lock. From then on the thread writes spans
+ *     into its own ring through a thread-local pointer. Rings outlive
+ *     their threads, so the spans of workers that have exited are still
+ *     there for Trace_write.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "assert.h"
+#include "mem.h"
+#include "trace.h"
+
+struct Span {
+        const char *name;
+        long begin, end;                /* ns since Trace_enable */
+        long arg;
+};
+
+struct Ring {
+        struct Span spans[TRACE_RING_SPANS];
+        long recorded;                  /* spans ever recorded */
+        int tid;
+        char name[32];
+        struct Ring *next;
+};
+
+static int enabled = 0;
+static struct timespec origin;
+static pthread_mutex_t ringsLock = PTHREAD_MUTEX_INITIALIZER;
+static struct Ring *rings = NULL;
+static int nrings = 0;
+static __thread struct Ring *ring = NULL;
+
+/* Returns nanoseconds since Trace_enable */
+static long now(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec - origin.tv_sec) * 1000000000L +
+               (ts.tv_nsec - origin.tv_nsec);
+}
+
+/*  own_ring
+ *
+ *  Purpose: Returns the calling thread's ring, making and listing it the
+ *           first time
+ */
+static struct Ring *own_ring(void)
+{
+        if (ring == NULL) {
+                struct Ring *r;
+                NEW(r);
+                r->recorded = 0;
+                r->name[0] = '\0';
+                pthread_mutex_lock(&ringsLock);
+                r->tid = ++nrings;
+                r->next = rings;
+                rings = r;
+                pthread_mutex_unlock(&ringsLock);
+                ring = r;
+        }
+        return ring;
+}
+
+void Trace_enable(void)
+{
+        clock_gettime(CLOCK_MONOTONIC, &origin);
+        snprintf(own_ring()->name, sizeof(ring->name), "main");
+        enabled = 1;
+}
+
+long Trace_begin(void)
+{
+        if (!enabled) {
+                return 0;
+        }
+        long t = now();
+        return t > 0 ? t : 1;
+}
+
+void Trace_end(const char *name, long begin, long arg)
+{
+        if (begin == 0) {
+                return;
+        }
+        struct Ring *r = own_ring();
+        struct Span *s = &r->spans[r->recorded % TRACE_RING_SPANS];
+        s->name = name;
+        s->begin = begin;
+        s->end = now();
+        s->arg = arg;
+        r->recorded++;
+}
+
+void Trace_name_thread(const char *name, int index)
+{
+        if (!enabled) {
+                return;
+        }
+        struct Ring *r = own_ring();
+        if (r->name[0] == '\0') {
+                snprintf(r->name, sizeof(r->name), "%s %d", name, index);
+        }
+}
+
+int Trace_write(const char *filename)
+{
+        assert(filename != NULL);
+        if (!enabled) {
+                return 0;
+        }
+        FILE *fp = fopen(filename, "w");
+        if (fp == NULL) {
+                return 0;
+        }
+
+        int pid = getpid();
+        long dropped = 0;
+        for (struct Ring *r = rings; r != NULL; r = r->next) {
+                if (r->recorded > TRACE_RING_SPANS) {
+                        dropped += r->recorded - TRACE_RING_SPANS;
+                }
+        }
+        fprintf(fp, "{\"displayTimeUnit\": \"ns\", "
+                    "\"otherData\": {\"dropped_spans\": %ld},\n"
+                    "\"traceEvents\": [", dropped);
+
+        /* Each thread's name, then its spans, oldest first. Times are in
+           microseconds */
+        const char *separator = "\n";
+        for (struct Ring *r = rings; r != NULL; r = r->next) {
+                if (r->name[0] == '\0') {
+                        snprintf(r->name, sizeof(r->name), "thread %d",
+                                 r->tid);
+                }
+                fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", "
+                            "\"pid\": %d, \"tid\": %d, "
+                            "\"args\": {\"name\": \"%s\"}}",
+                        separator, pid, r->tid, r->name);
+                separator = ",\n";
+                long first = r->recorded > TRACE_RING_SPANS ?
+                             r->recorded - TRACE_RING_SPANS : 0;
+                for (long i = first; i < r->recorded; i++) {
+                        struct Span *s = &r->spans[i % TRACE_RING_SPANS];
+                        fprintf(fp, "%s{\"name\": \"%s\", \"ph\": \"X\", "
+                                    "\"pid\": %d, \"tid\": %d, "
+                                    "\"ts\": %.3f, \"dur\": %.3f, "
+                                    "\"args\": {\"arg\": %ld}}",
+                                separator, s->name, pid, r->tid,
+                                s->begin / 1e3, (s->end - s->begin) / 1e3,
+                                s->arg);
+                }
+        }
+        fprintf(fp, "\n]}\n");
+        return fclose(fp) == 0;
+}
@@ -0,0 +1,54 @@
+/*
+ *     trace.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for recording a timeline of a run in the Chrome trace
+ *     event format, which chrome://tracing and Perfetto display as one row
+ *     of spans per thread. Each thread records its spans into its own ring
+ *     buffer, with no locks, so tracing every tile costs two clock reads;
+ *     with tracing off, a span costs a test of one flag.
+ *
+ *     Usage:
+ *
+ *       long span = Trace_begin();
+ *         ... work ...
+ *       Trace_end("tile", span, tileNumber);
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef TRACE_INCLUDED
+#define TRACE_INCLUDED
+
+/* Spans each thread keeps; when a thread records more, its oldest spans
+   are overwritten */
+#define TRACE_RING_SPANS 32768
+
+/* turns tracing on for the rest of the run; call before starting threads */
+extern void Trace_enable(void);
+
+/* returns the start of a span (nanoseconds since Trace_enable, at least 1),
+ * or 0 if tracing is off
+ */
+extern long Trace_begin(void);
+
+/* records a span from begin to now on the calling thread. name must stay
+ * valid until Trace_write (a string literal, say); arg is shown with the
+ * span. Does nothing if begin is 0.
+ */
+extern void Trace_end(const char *name, long begin, long arg);
+
+/* names the calling thread "name index" in the timeline, unless it has a
+ * name already. The thread that called Trace_enable is "main", and other
+ * unnamed threads are "thread N"
+ */
+extern void Trace_name_thread(const char *name, int index);
+
+/* writes every thread's spans to the named file as a trace event JSON
+ * object. Call when no other thread is recording.
+ *
+ * returns 1 on success, 0 if the file could not be written (or tracing is
+ * off)
+ */
+extern int Trace_write(const char *filename);
+
+#endif
@@ -6,8 +6,8 @@
  *     Implementation of the UArray2 interface. UArray2.c defines a number of
  *     operations that allow for a 2 dimensional array to be created, accessed,
  *     updated and deleted. The UArray2 is derived from the Hanson 1-D uarray
- *     and uses a single flat UArray with a length of width * height for the
- *     implementation.
+ *     and uses a single flat run of width * height cells, taken from an
+ *     allocator (see alloc.h), for the implementation.
  *
  *     Last Updated: 02.25.21
  */
@@ -17,13 +17,15 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <mem.h>
-#include <uarray.h>
+#include "alloc.h"
 
 #define T UArray2_T
 struct T {
   int width;
   int height;
-  UArray_T elems;
+  int size;
+  char *elems;
+  Alloc_T alloc;        /* where elems and this struct came from */
 };
 
 /*  UArray2_new
@@ -44,14 +46,25 @@ struct T {
  *
  */
 T UArray2_new(const int width, const int height, const int elem_size) {
+  return UArray2_new_in(width, height, elem_size, NULL);
+}
+
+/*  UArray2_new_in
+ *
+ *  Purpose: As UArray2_new, taking the array's memory from alloc (NULL
+ *           for the heap)
+ *
+ */
+T UArray2_new_in(const int width, const int height, const int elem_size,
+                 Alloc_T alloc) {
   assert(width > 0 && height > 0 && elem_size > 0);
 
-  T uarray2;
-  NEW(uarray2);
+  T uarray2 = Alloc_alloc(alloc, sizeof(*uarray2));
   uarray2->width = width;
   uarray2->height = height;
-  UArray_T temp = UArray_new(width * height, elem_size);
-  uarray2->elems = temp;
+  uarray2->size = elem_size;
+  uarray2->elems = Alloc_alloc(alloc, (long)width * height * elem_size);
+  uarray2->alloc = alloc;
 
   return uarray2;
 }
@@ -79,8 +92,10 @@ T UArray2_new(const int width, const int height, const int elem_size) {
  */
 void *UArray2_at(T uarray2, int col, int row) {
   assert(uarray2);
-  assert(col < uarray2->width && row < uarray2->height);
-  return UArray_at(uarray2->elems, (row * uarray2->width) + col);
+  assert(col >= 0 && col < uarray2->width &&
+         row >= 0 && row < uarray2->height);
+  return uarray2->elems +
+         ((long)row * uarray2->width + col) * uarray2->size;
 }
 
 /* UArray2_width
@@ -150,7 +165,7 @@ int UArray2_height(T uarray2) {
  */
 int UArray2_size(T uarray2) {
   assert(uarray2);
-  return UArray_size(uarray2->elems);
+  return uarray2->size;
 }
 
 /*  UArray2_map_col_major
@@ -176,7 +191,32 @@ void UArray2_map_col_major(T uarray2,
                 void apply(int col, int row, T uarray2, void *elem, void *cl),
                 void *cl) {
   assert(uarray2);
-  for (int col = 0; col < uarray2->width; col++) {
+  UArray2_map_col_range(uarray2, 0, uarray2->width, apply, cl);
+}
+
+/*  UArray2_map_col_range
+ *
+ *  Purpose:
+ *
+ *    Iterates through columns col0 to col1 - 1 of the array, varying the
+ *    row index fastest, and calls the apply function on each cell.
+ *
+ *  Parameters:
+ *
+ *    uarray2:    The array the apply function can perform operations on
+ *    col0, col1: The half-open range of columns to visit
+ *    apply:      The function called on each cell
+ *    cl:         Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2_map_col_range(T uarray2, int col0, int col1,
+                void apply(int col, int row, T uarray2, void *elem, void *cl),
+                void *cl) {
+  assert(uarray2);
+  assert(0 <= col0 && col0 <= col1 && col1 <= uarray2->width);
+  for (int col = col0; col < col1; col++) {
     for (int row = 0; row < uarray2->height; row++) {
       apply(col, row, uarray2, UArray2_at(uarray2, col, row), cl);
     }
@@ -206,13 +246,86 @@ void UArray2_map_row_major(T uarray2,
                 void apply(int col, int row, T uarray2, void *elem, void *cl),
                 void *cl) {
   assert(uarray2);
-  for (int row = 0; row < uarray2->height; row++) {
+  UArray2_map_row_range(uarray2, 0, uarray2->height, apply, cl);
+}
+
+/*  UArray2_map_row_range
+ *
+ *  Purpose:
+ *
+ *    Iterates through rows row0 to row1 - 1 of the array, varying the
+ *    column index fastest, and calls the apply function on each cell.
+ *
+ *  Parameters:
+ *
+ *    uarray2:    The array the apply function can perform operations on
+ *    row0, row1: The half-open range of rows to visit
+ *    apply:      The function called on each cell
+ *    cl:         Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2_map_row_range(T uarray2, int row0, int row1,
+                void apply(int col, int row, T uarray2, void *elem, void *cl),
+                void *cl) {
+  assert(uarray2);
+  assert(0 <= row0 && row0 <= row1 && row1 <= uarray2->height);
+  for (int row = row0; row < row1; row++) {
     for (int col = 0; col < uarray2->width; col++) {
       apply(col, row, uarray2, UArray2_at(uarray2, col, row), cl);
     }
   }
 }
 
+/*  UArray2_map_row_spans
+ *
+ *  Purpose:
+ *
+ *    Visits the array row by row like UArray2_map_row_major, but calls the
+ *    apply function once per row with the row's first cell and its length,
+ *    since every row is contiguous.
+ *
+ *  Parameters:
+ *
+ *    uarray2: The array the apply function can perform operations on
+ *    apply:   The function called on each row; the n cells from (col, row)
+ *             rightwards lie back to back from first
+ *    cl:      Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2_map_row_spans(T uarray2,
+                void apply(int col, int row, int n, T uarray2, void *first,
+                           void *cl),
+                void *cl) {
+  assert(uarray2);
+  long rowBytes = (long)uarray2->width * uarray2->size;
+  for (int row = 0; row < uarray2->height; row++) {
+    apply(0, row, uarray2->width, uarray2, uarray2->elems + row * rowBytes,
+          cl);
+  }
+}
+
+/*  UArray2_reshape
+ *
+ *  Purpose: Changes the width and height of the array without moving its
+ *           cells
+ *
+ *  Errors:
+ *
+ *    Raises runtime error if the number of cells would change
+ *
+ */
+void UArray2_reshape(T uarray2, int width, int height) {
+  assert(uarray2);
+  assert(width > 0 && height > 0);
+  assert((long)width * height == (long)uarray2->width * uarray2->height);
+  uarray2->width = width;
+  uarray2->height = height;
+}
+
 /*  UArray2_free
  *
  *  Purpose:
@@ -228,8 +341,10 @@ void UArray2_map_row_major(T uarray2,
  */
 void UArray2_free(T *uarray2) {
   assert(*uarray2);
-  UArray_free(&((*uarray2)->elems));
-  free(*uarray2);
+  Alloc_T alloc = (*uarray2)->alloc;
+  Alloc_release(alloc, (*uarray2)->elems);
+  Alloc_release(alloc, *uarray2);
+  *uarray2 = NULL;
 }
 
 #undef T
@@ -13,7 +13,7 @@
 #ifndef UARRAY2_H_INCLUDED
 #define UARRAY2_H_INCLUDED
 
-#include "uarray.h"
+#include "alloc.h"
 
 
 #define T UArray2_T
@@ -40,6 +40,22 @@ typedef struct T *T;
  */
 extern T UArray2_new(const int width, const int height, const int elem_size);
 
+/*  UArray2_new_in
+ *
+ *  Purpose:
+ *
+ *    Like UArray2_new, but takes the array's memory from alloc. With an
+ *    arena the cells are uninitialized, and UArray2_free releases nothing:
+ *    the memory goes back when the arena is reset.
+ *
+ *  Parameters: as for UArray2_new, plus
+ *
+ *    alloc:     allocator for the array, or NULL for the heap
+ *
+ */
+extern T UArray2_new_in(const int width, const int height,
+                        const int elem_size, Alloc_T alloc);
+
 /*  UArray2_at
  *
  *  Purpose:
@@ -172,6 +188,75 @@ extern void UArray2_map_row_major(T uarray2,
                 void apply(int col, int row, T uarray2, void *elem, void *cl),
                 void *cl);
 
+/*  UArray2_map_row_range
+ *
+ *  Purpose:
+ *
+ *    Like UArray2_map_row_major, but visits only rows row0 to row1 - 1.
+ *    Used to split a row-major traversal among threads.
+ *
+ *  Errors:
+ *
+ *    Raises runtime error unless 0 <= row0 <= row1 <= height
+ *
+ */
+extern void UArray2_map_row_range(T uarray2, int row0, int row1,
+                void apply(int col, int row, T uarray2, void *elem, void *cl),
+                void *cl);
+
+/*  UArray2_map_col_range
+ *
+ *  Purpose:
+ *
+ *    Like UArray2_map_col_major, but visits only columns col0 to col1 - 1.
+ *    Used to split a column-major traversal among threads.
+ *
+ *  Errors:
+ *
+ *    Raises runtime error unless 0 <= col0 <= col1 <= width
+ *
+ */
+extern void UArray2_map_col_range(T uarray2, int col0, int col1,
+                void apply(int col, int row, T uarray2, void *elem, void *cl),
+                void *cl);
+
+/*  UArray2_map_row_spans
+ *
+ *  Purpose:
+ *
+ *    Like UArray2_map_row_major, but calls apply once per row: the n cells
+ *    from (col, row) rightwards lie back to back starting at first.
+ *
+ */
+extern void UArray2_map_row_spans(T uarray2,
+                void apply(int col, int row, int n, T uarray2, void *first,
+                           void *cl),
+                void *cl);
+
+/*  UArray2_reshape
+ *
+ *  Purpose:
+ *
+ *    Changes the width and height of the array without moving its cells.
+ *    The cells are stored row by row, so cell k of the old shape is cell k
+ *    of the new one. Used to transpose an array in place.
+ *
+ *  Parameters:
+ *
+ *    uarray2: target array
+ *    width:   the new width
+ *    height:  the new height
+ *
+ *  Returns: nothing
+ *
+ *  Errors:
+ *
+ *    Raises runtime error if width * height differs from the number of
+ *    cells in the array
+ *
+ */
+extern void UArray2_reshape(T uarray2, int width, int height);
+
 /*  UArray2_free
  *
  *  Purpose:
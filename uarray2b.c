@@ -3,32 +3,43 @@
  *    BY Anesu Gavhera 02/18/2021
  *
  *    Interface for urray2b.c which declares implementation and member
- *    functions
+ *    functions. All blocks live in one cache-line-aligned allocation and are
+ *    laid out back to back, so a cell's address is a direct offset.
  *
  *
  *    Last Updated: 03.03.21
  */
 
-#include <uarray2.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include <mem.h>
-#include <uarray.h>
 #include <uarray2b.h>
 #include <math.h>
+#include "alloc.h"
 
 #define T UArray2b_T
-/* Struct for which the basis of uarray2b is made. elems is an array of
-    arrays */
+
+/* Alignment of the backing store; one cache line on the x86 machines we
+   time on (see the clflush size in the README) */
+#define CACHE_LINE 64
+
+/* Struct for which the basis of uarray2b is made. elems is one contiguous
+    cache-line-aligned region holding every block back to back in
+    block-row-major order; raw is the pointer actually returned by the
+    allocator alloc, kept so that it can be freed */
 struct T {
-    UArray2_T elems;
+    char *elems;
+    void *raw;
+    Alloc_T alloc;
     int width;
     int height;
     int size;
     int blocksize;
     int blockWidth;
     int blockHeight;
+    long blockBytes;
 };
 /*  UArray2b_new
  *
@@ -49,11 +60,22 @@ struct T {
  *
  */
 T UArray2b_new (int width, int height, int size, int blocksize) {
+    return UArray2b_new_in(width, height, size, blocksize, NULL);
+}
+
+/*  UArray2b_new_in
+ *
+ *  Purpose: As UArray2b_new, taking the array's memory from alloc (NULL
+ *           for the heap)
+ *
+ */
+T UArray2b_new_in(int width, int height, int size, int blocksize,
+                  Alloc_T alloc) {
     assert(width > 0 && height > 0 && blocksize > 1);
 
     /* Setup new UArray2b struct */
-    T uarray2b;
-    NEW(uarray2b);
+    T uarray2b = Alloc_alloc(alloc, sizeof(*uarray2b));
+    uarray2b->alloc = alloc;
     uarray2b->width = width;
     uarray2b->height = height;
     uarray2b->size = size;
@@ -69,17 +91,14 @@ T UArray2b_new (int width, int height, int size, int blocksize) {
         uarray2b->blockHeight++;
     }
 
-    /* Build the 2-D blocked UArray2 */
-    uarray2b->elems = UArray2_new(uarray2b->blockWidth, uarray2b->blockHeight,
-                        sizeof(UArray_T));
-
-    /* Create 1-D UArray in each block */
-    for (int i = 0; i < uarray2b->blockHeight; i++){
-        for (int j = 0; j < uarray2b->blockWidth; j++){
-            UArray_T *anArray = UArray2_at(uarray2b->elems, j, i);
-            *anArray =  UArray_new(blocksize * blocksize, size);
-        }
-    }
+    /* Allocate every block in one region, padded so that the first block
+       starts on a cache line boundary */
+    uarray2b->blockBytes = (long)blocksize * blocksize * size;
+    long totalBytes = uarray2b->blockBytes * uarray2b->blockWidth *
+                      uarray2b->blockHeight;
+    uarray2b->raw = Alloc_alloc(alloc, totalBytes + CACHE_LINE - 1);
+    uarray2b->elems = (char *)(((uintptr_t)uarray2b->raw + CACHE_LINE - 1) &
+                               ~(uintptr_t)(CACHE_LINE - 1));
     return uarray2b;
 }
 /*  UArray2b_new_64K_block
@@ -101,12 +120,58 @@ T UArray2b_new (int width, int height, int size, int blocksize) {
  *
  */
 T UArray2b_new_64K_block(int width, int height, int size) {
+    return UArray2b_new(width, height, size,
+                        UArray2b_blocksize_64K(size));
+}
+
+/*  UArray2b_blocksize_64K
+ *
+ *  Purpose: Returns the blocksize UArray2b_new_64K_block uses for cells of
+ *           the given size
+ *
+ */
+int UArray2b_blocksize_64K(int size) {
     int blocksize = sqrt(64 * 1024 / size);
     /* Blocksize should be at least 1 */
     if (blocksize < 1) {
         blocksize = 1;
     }
-    return UArray2b_new(width, height, size, blocksize);
+    return blocksize;
+}
+
+/* Picks the blocksize of arrays made without one; NULL for
+   UArray2b_blocksize_64K */
+static int (*chooseBlocksize)(int size, void *cl) = NULL;
+static void *chooseCl = NULL;
+
+/*  UArray2b_set_default_blocksize
+ *
+ *  Purpose: Replaces the rule UArray2b_default_blocksize follows
+ *
+ *  Parameters: function returning the blocksize for cells of a given size
+ *              (NULL restores UArray2b_blocksize_64K), and its closure
+ *
+ */
+void UArray2b_set_default_blocksize(int choose(int size, void *cl),
+                                    void *cl) {
+    chooseBlocksize = choose;
+    chooseCl = cl;
+}
+
+/*  UArray2b_default_blocksize
+ *
+ *  Purpose: Returns the blocksize to use for cells of the given size when
+ *           the caller does not pick one
+ *
+ */
+int UArray2b_default_blocksize(int size) {
+    assert(size > 0);
+    if (chooseBlocksize == NULL) {
+        return UArray2b_blocksize_64K(size);
+    }
+    int blocksize = chooseBlocksize(size, chooseCl);
+    assert(blocksize > 1);
+    return blocksize;
 }
 
 /*  UArray2b_free
@@ -124,18 +189,12 @@ T UArray2b_new_64K_block(int width, int height, int size) {
  *    Notes: closes with a runtime error if array parameter is NULL
  */
 void UArray2b_free (T *array2b) {
-    assert(array2b != NULL);
-
-    /* Free each of the inner UArrays in this 2-D UArray2 */
-    for (int i = 0; i < (*array2b)->blockHeight; i++) {
-        for (int j = 0; j < (*array2b)->blockWidth; j++) {
-            UArray_T *anArray = UArray2_at((*array2b)->elems, j, i);
-            UArray_free(anArray);
-        }
-    }
+    assert(array2b != NULL && *array2b != NULL);
 
-    UArray2_free(&((*array2b)->elems));
-    FREE(*array2b);
+    Alloc_T alloc = (*array2b)->alloc;
+    Alloc_release(alloc, (*array2b)->raw);
+    Alloc_release(alloc, *array2b);
+    *array2b = NULL;
 }
 /* UArray2b_width
  *
@@ -227,6 +286,21 @@ int UArray2b_blocksize(T array2b) {
     assert(array2b != NULL);
     return array2b->blocksize;
 }
+/*  UArray2b_block_rows
+ *
+ *  Purpose:
+ *
+ *    Returns the number of rows of blocks, including a partial last row
+ *
+ *  Errors:
+ *
+ *    Raises runtime error if array parameter is a NULL pointer
+ *
+ */
+int UArray2b_block_rows(T array2b) {
+    assert(array2b != NULL);
+    return array2b->blockHeight;
+}
 /*  UArray2b_at
  *
  *  Purpose:
@@ -251,14 +325,16 @@ int UArray2b_blocksize(T array2b) {
 void *UArray2b_at(T array2b, int column, int row) {
 
     assert(array2b != NULL);
-    /* Retrive the correct block */
-    UArray_T *anArray = UArray2_at(array2b->elems,
-                                    column / array2b->blocksize,
-                                    row / array2b->blocksize);
-    /* Get correct element index */
-    int index = array2b->blocksize * (row % array2b->blocksize) +
-                      (column % array2b->blocksize);
-    return UArray_at(*anArray, index);
+    assert(column >= 0 && column < array2b->width &&
+           row >= 0 && row < array2b->height);
+    int blocksize = array2b->blocksize;
+
+    /* Offset of the correct block, then of the element inside it */
+    long block = (long)(row / blocksize) * array2b->blockWidth +
+                 column / blocksize;
+    long index = (long)blocksize * (row % blocksize) + column % blocksize;
+    return array2b->elems + block * array2b->blockBytes +
+           index * array2b->size;
 }
 
 /* UArray2b_map
@@ -283,22 +359,129 @@ void UArray2b_map(T array2b,
                 void apply(int col, int row, T array2b, void *elem, void *cl),
                 void *cl) {
     assert(array2b != NULL);
+    UArray2b_map_block_rows(array2b, 0, array2b->blockHeight, apply, cl);
+}
 
-    /* Iterate over each block and run the apply function */
-    for (int row = 0; row < array2b->blockHeight; row++) {
+/* UArray2b_map_block_rows
+ *
+ *  Purpose:
+ *
+ *    Like UArray2b_map, but visits only the blocks in block rows row0 to
+ *    row1 - 1. Used to split a block-major traversal among threads.
+ *
+ *  Parameters:
+ *
+ *    uarray2b:   The array the apply function can perform operations on
+ *    row0, row1: The half-open range of block rows to visit
+ *    apply:      The function called on each cell
+ *    cl:         Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2b_map_block_rows(T array2b, int row0, int row1,
+                void apply(int col, int row, T array2b, void *elem, void *cl),
+                void *cl) {
+    assert(array2b != NULL);
+    assert(0 <= row0 && row0 <= row1 && row1 <= array2b->blockHeight);
+    int blocksize = array2b->blocksize;
+    char *block = array2b->elems +
+                  (long)row0 * array2b->blockWidth * array2b->blockBytes;
+
+    /* Blocks are stored back to back, so walk the region in address order
+       and run the apply function on every in-range cell */
+    for (int row = row0; row < row1; row++) {
         for (int col = 0; col < array2b->blockWidth; col++) {
-            UArray_T *temp = UArray2_at(array2b->elems, col, row);
-            for (int i = 0; i < UArray_length(*temp); i++) {
-                int correctcol = (i % array2b->blocksize) +
-                                (array2b->blocksize * col);
-                int correctrow = (i / array2b->blocksize) +
-                                (row * array2b->blocksize);
-                if (correctcol < array2b->width &&
-                    correctrow < array2b->height) {
-                    apply(correctcol, correctrow, array2b,
-                            UArray_at(*temp, i), cl);
+            char *elem = block;
+            for (int j = 0; j < blocksize; j++) {
+                int correctrow = row * blocksize + j;
+                for (int i = 0; i < blocksize; i++) {
+                    int correctcol = col * blocksize + i;
+                    if (correctcol < array2b->width &&
+                        correctrow < array2b->height) {
+                        apply(correctcol, correctrow, array2b, elem, cl);
+                    }
+                    elem += array2b->size;
                 }
             }
+            block += array2b->blockBytes;
+        }
+    }
+}
+
+/* UArray2b_map_block_spans
+ *
+ *  Purpose:
+ *
+ *    Visits the blocks in the same order as UArray2b_map, but calls the
+ *    apply function once per row of each block with the row's first cell
+ *    and the number of in-range cells in it, which lie back to back.
+ *
+ *  Parameters:
+ *
+ *    uarray2b: The array the apply function can perform operations on
+ *    apply:    The function called on each block row
+ *    cl:       Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2b_map_block_spans(T array2b,
+                void apply(int col, int row, int n, T array2b, void *first,
+                           void *cl),
+                void *cl) {
+    assert(array2b != NULL);
+    int blocksize = array2b->blocksize;
+    long rowBytes = (long)blocksize * array2b->size;
+    char *block = array2b->elems;
+
+    for (int blockRow = 0; blockRow < array2b->blockHeight; blockRow++) {
+        int row0 = blockRow * blocksize;
+        int rows = array2b->height - row0 < blocksize ?
+                   array2b->height - row0 : blocksize;
+        for (int blockCol = 0; blockCol < array2b->blockWidth; blockCol++) {
+            int col0 = blockCol * blocksize;
+            int n = array2b->width - col0 < blocksize ?
+                    array2b->width - col0 : blocksize;
+            for (int j = 0; j < rows; j++) {
+                apply(col0, row0 + j, n, array2b, block + j * rowBytes, cl);
+            }
+            block += array2b->blockBytes;
+        }
+    }
+}
+
+/* UArray2b_map_row_spans
+ *
+ *  Purpose:
+ *
+ *    Visits the array row by row, columns increasing, calling the apply
+ *    function once for the part of the row inside each block, which is
+ *    the longest run of the row that lies back to back.
+ *
+ *  Parameters: as for UArray2b_map_block_spans
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2b_map_row_spans(T array2b,
+                void apply(int col, int row, int n, T array2b, void *first,
+                           void *cl),
+                void *cl) {
+    assert(array2b != NULL);
+    int blocksize = array2b->blocksize;
+
+    for (int row = 0; row < array2b->height; row++) {
+        /* Start of this row in the first block of its block row */
+        char *first = array2b->elems +
+                      (long)(row / blocksize) * array2b->blockWidth *
+                      array2b->blockBytes +
+                      (long)(row % blocksize) * blocksize * array2b->size;
+        for (int col = 0; col < array2b->width; col += blocksize) {
+            int n = array2b->width - col < blocksize ?
+                    array2b->width - col : blocksize;
+            apply(col, row, n, array2b, first, cl);
+            first += array2b->blockBytes;
         }
     }
 }
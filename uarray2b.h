@@ -9,10 +9,12 @@
  */
 #ifndef UARRAY2B_INCLUDED
 #define UARRAY2B_INCLUDED
+#include "alloc.h"
 #define T UArray2b_T
 typedef struct T *T;
 /*
-* new blocked 2d array
+* new blocked 2d array, stored as one cache-line-aligned region with the
+* blocks laid out back to back
 * blocksize = square root of # of cells in block.
 * blocksize < 1 is a checked runtime error
 */
@@ -21,6 +23,24 @@ extern T UArray2b_new (int width, int height, int size, int blocksize);
 * block occupies at most 64KB (if possible)
 */
 extern T UArray2b_new_64K_block(int width, int height, int size);
+/* the blocksize UArray2b_new_64K_block picks for cells of 'size' bytes */
+extern int UArray2b_blocksize_64K(int size);
+/* the blocksize to use for cells of 'size' bytes when the caller does
+* not pick one: UArray2b_blocksize_64K(size) unless replaced by
+* UArray2b_set_default_blocksize
+*/
+extern int UArray2b_default_blocksize(int size);
+/* makes UArray2b_default_blocksize return choose(size, cl), which must be
+* at least 2; a NULL choose restores the 64KB rule. Not thread-safe.
+*/
+extern void UArray2b_set_default_blocksize(int choose(int size, void *cl),
+                                           void *cl);
+/* like UArray2b_new, but takes the memory from alloc (NULL for the heap);
+* with an arena the cells are uninitialized and UArray2b_free releases
+* nothing
+*/
+extern T UArray2b_new_in(int width, int height, int size, int blocksize,
+                         Alloc_T alloc);
 extern void UArray2b_free (T *array2b);
 extern int UArray2b_width (T array2b);
 extern int UArray2b_height (T array2b);
@@ -34,6 +54,28 @@ extern void *UArray2b_at(T array2b, int column, int row);
 extern void UArray2b_map(T array2b,
                 void apply(int col, int row, T array2b, void *elem, void *cl),
                 void *cl);
+/* number of rows of blocks, counting a partial last row */
+extern int UArray2b_block_rows(T array2b);
+/* like UArray2b_map, but only visits the blocks in block rows
+* row0 to row1 - 1
+*/
+extern void UArray2b_map_block_rows(T array2b, int row0, int row1,
+                void apply(int col, int row, T array2b, void *elem, void *cl),
+                void *cl);
+/* like UArray2b_map, but calls apply once per row of each block: the n
+* in-range cells from (col, row) rightwards lie back to back from first
+*/
+extern void UArray2b_map_block_spans(T array2b,
+                void apply(int col, int row, int n, T array2b, void *first,
+                           void *cl),
+                void *cl);
+/* visits every row in order, calling apply once for the run of the row
+* inside each block, from left to right
+*/
+extern void UArray2b_map_row_spans(T array2b,
+                void apply(int col, int row, int n, T array2b, void *first,
+                           void *cl),
+                void *cl);
 /*
 * it is a checked run-time error to pass a NULL T
 * to any function in this interface
@@ -0,0 +1,465 @@
+/*
+ *    uarray2m.c
+ *    BY Anesu Gavhera 02/18/2021
+ *
+ *    Implementation of the UArray2m interface. Cells are stored in tiled
+ *    Morton (Z-order): the array is covered by square tiles whose side is
+ *    the smallest power of two that fits the shorter dimension, but no
+ *    more than TILE_BITS bits, the tiles are stored row by row, and within
+ *    a tile a cell's index is the bit interleaving of its column (even
+ *    bits) and row (odd bits). Padding is therefore less than one tile
+ *    along each side.
+ *
+ *
+ *    Last Updated: 03.03.21
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <mem.h>
+#include <uarray2m.h>
+#include "alloc.h"
+
+#define T UArray2m_T
+
+/* log2 of the largest tile side: 64 x 64 cells, 48KB of Pnm_rgb */
+#define TILE_BITS 6
+
+/* Struct for which the basis of uarray2m is made. elems holds every tile
+    back to back, row of tiles by row of tiles; tileBits is log2 of the
+    side of one tile */
+struct T {
+    char *elems;
+    int width;
+    int height;
+    int size;
+    int tileBits;
+    int tilesWide;
+    int tilesHigh;
+    Alloc_T alloc;
+};
+
+/*  spread_bits
+ *
+ *  Purpose: Moves bit k of x to bit 2k of the result, leaving zeros in the
+ *           odd bit positions
+ *
+ *  Parameters:
+ *
+ *    x: the coordinate to spread
+ *
+ *  Returns: x with a zero bit inserted above each of its bits
+ *
+ */
+static inline uint64_t spread_bits(uint32_t x)
+{
+    uint64_t v = x;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v << 8))  & 0x00FF00FF00FF00FFULL;
+    v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v << 2))  & 0x3333333333333333ULL;
+    v = (v | (v << 1))  & 0x5555555555555555ULL;
+    return v;
+}
+
+/*  compact_bits
+ *
+ *  Purpose: Inverse of spread_bits; gathers the even bits of v
+ *
+ *  Parameters:
+ *
+ *    v: a Morton index (or the Morton index shifted right by one)
+ *
+ *  Returns: the coordinate stored in the even bits of v
+ *
+ */
+static inline uint32_t compact_bits(uint64_t v)
+{
+    v &= 0x5555555555555555ULL;
+    v = (v | (v >> 1))  & 0x3333333333333333ULL;
+    v = (v | (v >> 2))  & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v >> 4))  & 0x00FF00FF00FF00FFULL;
+    v = (v | (v >> 8))  & 0x0000FFFF0000FFFFULL;
+    v = (v | (v >> 16)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t)v;
+}
+
+/*  morton_index
+ *
+ *  Purpose: Computes the index of the cell at (col, row)
+ *
+ *  Parameters:
+ *
+ *    array2m: array whose layout is used
+ *    col:     column index position
+ *    row:     row index position
+ *
+ *  Returns: the cell's position in elems, counted in cells
+ *
+ */
+static inline uint64_t morton_index(T array2m, int col, int row)
+{
+    int bits = array2m->tileBits;
+    uint32_t mask = ((uint32_t)1 << bits) - 1;
+    uint64_t tile = (uint64_t)((uint32_t)row >> bits) * array2m->tilesWide +
+                    ((uint32_t)col >> bits);
+    return (tile << (2 * bits)) | spread_bits(col & mask) |
+           (spread_bits(row & mask) << 1);
+}
+
+/*  UArray2m_new
+ *
+ *  Purpose: Defines a new 2-dimensional array stored in Morton order
+ *
+ *  Parameters:
+ *
+ *    width:     The width of the 2D grid or length of a single row
+ *    height:    The height of the 2D grid or number of rows
+ *    size:      The size of a single element that should be designated to be
+ *               stored on the heap.
+ *
+ *  Returns: An empty UArray2m_T of the specified width and height
+ *
+ *  Note: Memory is allocated on the heap which means it needs to be cleaned up.
+ *        Storage is padded to whole tiles, less than 64 cells along each
+ *        side.
+ *
+ */
+T UArray2m_new (int width, int height, int size) {
+    return UArray2m_new_in(width, height, size, NULL);
+}
+
+/*  UArray2m_new_in
+ *
+ *  Purpose: As UArray2m_new, taking the array's memory from alloc (NULL
+ *           for the heap)
+ *
+ */
+T UArray2m_new_in(int width, int height, int size, Alloc_T alloc) {
+    assert(width > 0 && height > 0 && size > 0);
+
+    T array2m = Alloc_alloc(alloc, sizeof(*array2m));
+    array2m->alloc = alloc;
+    array2m->width = width;
+    array2m->height = height;
+    array2m->size = size;
+
+    /* Smallest power of two that covers the shorter side, up to the
+       largest tile */
+    int shortSide = width < height ? width : height;
+    array2m->tileBits = 0;
+    while ((1 << array2m->tileBits) < shortSide &&
+           array2m->tileBits < TILE_BITS) {
+        array2m->tileBits++;
+    }
+    int side = 1 << array2m->tileBits;
+    array2m->tilesWide = (width + side - 1) / side;
+    array2m->tilesHigh = (height + side - 1) / side;
+
+    array2m->elems = Alloc_alloc(alloc, UArray2m_cells(array2m) * size);
+    return array2m;
+}
+
+/*  UArray2m_free
+ *
+ *  Purpose:
+ *
+ *    Deallocates the memory of the UArray2m_T passed in
+ *
+ *  Parameters:
+ *
+ *    array2m: the address of the array to be freed
+ *
+ *  Returns: nothing
+ *
+ *    Notes: closes with a runtime error if array parameter is NULL
+ */
+void UArray2m_free (T *array2m) {
+    assert(array2m != NULL && *array2m != NULL);
+    Alloc_T alloc = (*array2m)->alloc;
+    Alloc_release(alloc, (*array2m)->elems);
+    Alloc_release(alloc, *array2m);
+    *array2m = NULL;
+}
+
+/* UArray2m_width
+ *
+ *  Purpose: Returns the width of the 2D array (number of columns)
+ *
+ *  Errors: Raises runtime error if array parameter is a NULL pointer
+ *
+ */
+int UArray2m_width (T array2m) {
+    assert(array2m != NULL);
+    return array2m->width;
+}
+
+/* UArray2m_height
+ *
+ *  Purpose: Returns the height of the 2D array (number of rows)
+ *
+ *  Errors: Raises runtime error if array parameter is a NULL pointer
+ *
+ */
+int UArray2m_height (T array2m) {
+    assert(array2m != NULL);
+    return array2m->height;
+}
+
+/*  UArray2m_size
+ *
+ *  Purpose: Returns the size an element of the 2D array
+ *
+ *  Errors: Raises runtime error if array parameter is a NULL pointer
+ *
+ */
+int UArray2m_size (T array2m) {
+    assert(array2m != NULL);
+    return array2m->size;
+}
+
+/*  UArray2m_at
+ *
+ *  Purpose:
+ *
+ *    Returns the element at a specific position within the 2d array
+ *
+ *  Parameters:
+ *
+ *    array2m : array from which element should be searched from
+ *    column  : column index position
+ *    row     : row index position
+ *
+ *  Returns:
+ *
+ *     Void pointer representing the location of the element requested
+ *
+ *  Errors:
+ *
+ *    Raises runtime error if col and row index positions are out of range
+ *
+ */
+void *UArray2m_at(T array2m, int column, int row) {
+    assert(array2m != NULL);
+    assert(column >= 0 && column < array2m->width &&
+           row >= 0 && row < array2m->height);
+    return array2m->elems +
+           morton_index(array2m, column, row) * array2m->size;
+}
+
+/* UArray2m_map
+ *
+ *  Purpose:
+ *
+ *    Iterates through the array in Morton order, which is also the order of
+ *    the cells in memory, skipping the padding outside the image
+ *
+ *  Parameters:
+ *
+ *    array2m: The array the apply function can perform operations on
+ *    apply:   The interface for the function the end user will pass in to
+ *             perform operations on
+ *    cl:      A pointer that allows for any type of data to be passed through
+ *             to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map(T array2m,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    UArray2m_map_range(array2m, 0, UArray2m_cells(array2m), apply, cl);
+}
+
+/*  UArray2m_cells
+ *
+ *  Purpose: Returns the number of cells stored, padding included
+ *
+ *  Errors: Raises runtime error if array parameter is a NULL pointer
+ *
+ */
+long UArray2m_cells(T array2m) {
+    assert(array2m != NULL);
+    return (long)array2m->tilesWide * array2m->tilesHigh <<
+           (2 * array2m->tileBits);
+}
+
+/* UArray2m_map_range
+ *
+ *  Purpose:
+ *
+ *    Iterates through Morton indices first to last - 1 in order, skipping
+ *    the padding outside the image. Used to split a Morton-order traversal
+ *    among threads.
+ *
+ *  Parameters:
+ *
+ *    array2m:     The array the apply function can perform operations on
+ *    first, last: The half-open range of Morton indices to visit
+ *    apply:       The function called on each cell
+ *    cl:          Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map_range(T array2m, long first, long last,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    assert(0 <= first && first <= last && last <= UArray2m_cells(array2m));
+    int bits = array2m->tileBits;
+    uint64_t mask = ((uint64_t)1 << (2 * bits)) - 1;
+    char *elem = array2m->elems + first * array2m->size;
+
+    for (uint64_t i = first; i < (uint64_t)last; i++) {
+        long tile = (long)(i >> (2 * bits));
+        int col = compact_bits(i & mask) +
+                  (int)(tile % array2m->tilesWide << bits);
+        int row = compact_bits((i & mask) >> 1) +
+                  (int)(tile / array2m->tilesWide << bits);
+        if (col < array2m->width && row < array2m->height) {
+            apply(col, row, array2m, elem, cl);
+        }
+        elem += array2m->size;
+    }
+}
+
+/* UArray2m_map_row_major
+ *
+ *  Purpose:
+ *
+ *    Iterates through the array row by row. The interleaved row bits are
+ *    computed once per row, so each step only spreads the column.
+ *
+ *  Parameters: as for UArray2m_map
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map_row_major(T array2m,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    UArray2m_map_row_range(array2m, 0, array2m->height, apply, cl);
+}
+
+/* UArray2m_map_row_range
+ *
+ *  Purpose: As UArray2m_map_row_major, over rows row0 to row1 - 1
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map_row_range(T array2m, int row0, int row1,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    assert(0 <= row0 && row0 <= row1 && row1 <= array2m->height);
+    int bits = array2m->tileBits;
+    uint32_t mask = ((uint32_t)1 << bits) - 1;
+
+    for (int row = row0; row < row1; row++) {
+        uint64_t rowPart = (spread_bits(row & mask) << 1) +
+                           ((uint64_t)((uint32_t)row >> bits) *
+                            array2m->tilesWide << (2 * bits));
+        for (int col = 0; col < array2m->width; col++) {
+            uint64_t index = rowPart + spread_bits(col & mask) +
+                ((uint64_t)((uint32_t)col >> bits) << (2 * bits));
+            apply(col, row, array2m,
+                  array2m->elems + index * array2m->size, cl);
+        }
+    }
+}
+
+/* UArray2m_map_col_major
+ *
+ *  Purpose:
+ *
+ *    Iterates through the array column by column. The interleaved column
+ *    bits are computed once per column, so each step only spreads the row.
+ *
+ *  Parameters: as for UArray2m_map
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map_col_major(T array2m,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    UArray2m_map_col_range(array2m, 0, array2m->width, apply, cl);
+}
+
+/* UArray2m_map_col_range
+ *
+ *  Purpose: As UArray2m_map_col_major, over columns col0 to col1 - 1
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map_col_range(T array2m, int col0, int col1,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    assert(0 <= col0 && col0 <= col1 && col1 <= array2m->width);
+    int bits = array2m->tileBits;
+    uint32_t mask = ((uint32_t)1 << bits) - 1;
+
+    for (int col = col0; col < col1; col++) {
+        uint64_t colPart = spread_bits(col & mask) +
+                           ((uint64_t)((uint32_t)col >> bits) << (2 * bits));
+        for (int row = 0; row < array2m->height; row++) {
+            uint64_t index = colPart + (spread_bits(row & mask) << 1) +
+                ((uint64_t)((uint32_t)row >> bits) * array2m->tilesWide <<
+                 (2 * bits));
+            apply(col, row, array2m,
+                  array2m->elems + index * array2m->size, cl);
+        }
+    }
+}
+
+/* UArray2m_map_row_spans
+ *
+ *  Purpose:
+ *
+ *    Visits the array row by row like UArray2m_map_row_major, calling the
+ *    apply function once per run of the row whose cells are consecutive in
+ *    Morton order. Column bit 0 is the lowest bit of the index, so runs are
+ *    usually pairs of cells; only an array one cell high or wide has
+ *    longer ones.
+ *
+ *  Parameters:
+ *
+ *    array2m: The array the apply function can perform operations on
+ *    apply:   The function called on each run; the n cells from (col, row)
+ *             rightwards lie back to back from first
+ *    cl:      Closure passed through to the apply function
+ *
+ *  Returns: nothing
+ *
+ */
+void UArray2m_map_row_spans(T array2m,
+                void apply(int col, int row, int n, T array2m, void *first,
+                           void *cl),
+                void *cl) {
+    assert(array2m != NULL);
+    for (int row = 0; row < array2m->height; row++) {
+        int col = 0;
+        while (col < array2m->width) {
+            uint64_t index = morton_index(array2m, col, row);
+            int n = 1;
+            while (col + n < array2m->width &&
+                   morton_index(array2m, col + n, row) == index + n) {
+                n++;
+            }
+            apply(col, row, n, array2m, array2m->elems +
+                  index * array2m->size, cl);
+            col += n;
+        }
+    }
+}
+
+#undef T
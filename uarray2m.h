@@ -0,0 +1,76 @@
+/*
+ *    uarray2m.h
+ *    BY Anesu Gavhera 02/18/2021
+ *
+ *    2d array stored in Morton (Z-order). Cells are numbered by interleaving
+ *    the bits of their column and row, so cells that are close in either
+ *    direction are usually close in memory.
+ *
+ *
+ *    Last Updated: 03.03.21
+ */
+#ifndef UARRAY2M_INCLUDED
+#define UARRAY2M_INCLUDED
+#include "alloc.h"
+#define T UArray2m_T
+typedef struct T *T;
+/*
+* new Morton-order 2d array
+* width < 1, height < 1 or size < 1 is a checked runtime error
+*/
+extern T UArray2m_new (int width, int height, int size);
+/* like UArray2m_new, but takes the memory from alloc (NULL for the heap);
+* with an arena the cells are uninitialized and UArray2m_free releases
+* nothing
+*/
+extern T UArray2m_new_in(int width, int height, int size, Alloc_T alloc);
+extern void UArray2m_free (T *array2m);
+extern int UArray2m_width (T array2m);
+extern int UArray2m_height (T array2m);
+extern int UArray2m_size (T array2m);
+/* return a pointer to the cell in the given column and row.
+* index out of range is a checked run-time error
+*/
+extern void *UArray2m_at(T array2m, int column, int row);
+/* visits every cell in increasing Morton order (i.e. in address order) */
+extern void UArray2m_map(T array2m,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl);
+/* visits every cell row by row, columns increasing within a row */
+extern void UArray2m_map_row_major(T array2m,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl);
+/* visits every cell column by column, rows increasing within a column */
+extern void UArray2m_map_col_major(T array2m,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl);
+/* number of cells in Morton order, including the padding outside the
+* array; UArray2m_map visits the in-range ones among indices 0 to cells - 1
+*/
+extern long UArray2m_cells(T array2m);
+/* like UArray2m_map, but only visits Morton indices first to last - 1 */
+extern void UArray2m_map_range(T array2m, long first, long last,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl);
+/* like UArray2m_map_row_major, but only visits rows row0 to row1 - 1 */
+extern void UArray2m_map_row_range(T array2m, int row0, int row1,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl);
+/* like UArray2m_map_col_major, but only visits columns col0 to col1 - 1 */
+extern void UArray2m_map_col_range(T array2m, int col0, int col1,
+                void apply(int col, int row, T array2m, void *elem, void *cl),
+                void *cl);
+/* visits every row in order, calling apply once per run of the row that
+* is consecutive in Morton order: the n cells from (col, row) rightwards lie
+* back to back from first
+*/
+extern void UArray2m_map_row_spans(T array2m,
+                void apply(int col, int row, int n, T array2m, void *first,
+                           void *cl),
+                void *cl);
+/*
+* it is a checked run-time error to pass a NULL T
+* to any function in this interface
+*/
+#undef T
+#endif
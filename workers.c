@@ -0,0 +1,171 @@
+/*
+ *     workers.c
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Implementation of the worker pool. A job is published by bumping a
+ *     generation counter under the pool's lock; each worker waits for the
+ *     counter to change, runs its index, and the last one to finish wakes
+ *     the caller.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#include <stdlib.h>
+#include <pthread.h>
+#include "assert.h"
+#include "mem.h"
+#include "workers.h"
+
+#define T Workers_T
+
+struct Worker {
+        T pool;
+        int index;
+};
+
+struct T {
+        int nthreads;
+        pthread_t *threads;
+        struct Worker *workers;
+
+        pthread_mutex_t lock;
+        pthread_cond_t start;
+        pthread_cond_t done;
+        unsigned long generation;
+        int pending;                    /* workers still running the job */
+        int quit;
+
+        Workers_task *task;
+        void *cl;
+};
+
+static T shared = NULL;
+
+/* Body of each started thread: run every job published after it started */
+static void *worker_loop(void *arg)
+{
+        struct Worker *worker = arg;
+        T pool = worker->pool;
+        unsigned long seen = 0;
+
+        pthread_mutex_lock(&pool->lock);
+        for (;;) {
+                while (pool->generation == seen && !pool->quit) {
+                        pthread_cond_wait(&pool->start, &pool->lock);
+                }
+                if (pool->quit) {
+                        break;
+                }
+                seen = pool->generation;
+                Workers_task *task = pool->task;
+                void *cl = pool->cl;
+                pthread_mutex_unlock(&pool->lock);
+
+                task(worker->index, cl);
+
+                pthread_mutex_lock(&pool->lock);
+                if (--pool->pending == 0) {
+                        pthread_cond_signal(&pool->done);
+                }
+        }
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+}
+
+T Workers_new(int nthreads)
+{
+        assert(nthreads >= 1);
+        T pool;
+        NEW(pool);
+        pool->nthreads = nthreads;
+        pool->generation = 0;
+        pool->pending = 0;
+        pool->quit = 0;
+        pool->task = NULL;
+        pool->cl = NULL;
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_cond_init(&pool->start, NULL);
+        pthread_cond_init(&pool->done, NULL);
+
+        pool->threads = CALLOC(nthreads, sizeof(pthread_t));
+        pool->workers = CALLOC(nthreads, sizeof(struct Worker));
+        for (int i = 1; i < nthreads; i++) {
+                pool->workers[i].pool = pool;
+                pool->workers[i].index = i;
+                int err = pthread_create(&pool->threads[i], NULL,
+                                         worker_loop, &pool->workers[i]);
+                assert(err == 0);
+        }
+        return pool;
+}
+
+void Workers_free(T *workers)
+{
+        assert(workers != NULL && *workers != NULL);
+        T pool = *workers;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->quit = 1;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+        for (int i = 1; i < pool->nthreads; i++) {
+                pthread_join(pool->threads[i], NULL);
+        }
+
+        pthread_cond_destroy(&pool->done);
+        pthread_cond_destroy(&pool->start);
+        pthread_mutex_destroy(&pool->lock);
+        FREE(pool->threads);
+        FREE(pool->workers);
+        if (shared == pool) {
+                shared = NULL;
+        }
+        FREE(pool);
+        *workers = NULL;
+}
+
+int Workers_count(T workers)
+{
+        assert(workers != NULL);
+        return workers->nthreads;
+}
+
+void Workers_run(T workers, Workers_task task, void *cl)
+{
+        assert(workers != NULL && task != NULL);
+
+        pthread_mutex_lock(&workers->lock);
+        workers->task = task;
+        workers->cl = cl;
+        workers->pending = workers->nthreads - 1;
+        workers->generation++;
+        pthread_cond_broadcast(&workers->start);
+        pthread_mutex_unlock(&workers->lock);
+
+        task(0, cl);
+
+        pthread_mutex_lock(&workers->lock);
+        while (workers->pending > 0) {
+                pthread_cond_wait(&workers->done, &workers->lock);
+        }
+        pthread_mutex_unlock(&workers->lock);
+}
+
+T Workers_shared(int nthreads)
+{
+        if (shared != NULL && shared->nthreads != nthreads) {
+                Workers_free(&shared);
+        }
+        if (shared == NULL) {
+                shared = Workers_new(nthreads);
+        }
+        return shared;
+}
+
+void Workers_split(int n, int parts, int index, int *lo, int *hi)
+{
+        assert(n >= 0 && parts >= 1 && index >= 0 && index < parts);
+        *lo = (int)((long)n * index / parts);
+        *hi = (int)((long)n * (index + 1) / parts);
+}
+
+#undef T
@@ -0,0 +1,47 @@
+/*
+ *     workers.h
+ *     BY Anesu Gavhera 03/05/2021
+ *
+ *     Interface for a pool of pthread workers. A pool of n workers runs a
+ *     job by calling task(index, cl) once for every index in [0, n), each
+ *     index on its own thread (index 0 on the calling thread), and returns
+ *     when every call has finished. The threads are created once and reused
+ *     for every job.
+ *
+ *     Last Updated: 03/08/2021
+ */
+#ifndef WORKERS_INCLUDED
+#define WORKERS_INCLUDED
+
+#define T Workers_T
+typedef struct T *T;
+
+typedef void Workers_task(int index, void *cl);
+
+/* creates a pool of nthreads workers (nthreads < 1 is a checked run-time
+ * error); nthreads - 1 threads are started, the caller being the last
+ */
+extern T Workers_new(int nthreads);
+
+/* stops and joins the threads, frees *workers and sets it to NULL */
+extern void Workers_free(T *workers);
+
+extern int Workers_count(T workers);
+
+/* runs task(i, cl) for every i in [0, Workers_count(workers)) and waits
+ * for all of them. Jobs must not be started from inside a task.
+ */
+extern void Workers_run(T workers, Workers_task task, void *cl);
+
+/* returns a process-wide pool of nthreads workers, replacing the previous
+ * one if it was a different size. Not safe to call from several threads.
+ */
+extern T Workers_shared(int nthreads);
+
+/* splits [0, n) into 'parts' nearly equal ranges and stores the bounds of
+ * range 'index' in [*lo, *hi)
+ */
+extern void Workers_split(int n, int parts, int index, int *lo, int *hi);
+
+#undef T
+#endif